@@ -0,0 +1,146 @@
+/*********************************************************************
+ This is a library for SHARP Memory Display
+
+ Written by Mark Winney.
+ BSD license, check license.txt for more information
+ All text above, and the splash screen must be included in any redistribution
+ *********************************************************************/
+
+#include <SPI.h>
+#include "Sharp_Strip.h"
+
+// Commands, in the bit order they are sent (LSB first)
+#define SHARPMEM_BIT_WRITECMD	0x01
+#define SHARPMEM_BIT_CLEAR	0x04
+
+#define SHARPMEM_SPI_FREQ	2000000
+
+SharpStrip::SharpStrip (uint8_t ss, uint16_t width, uint16_t height, uint8_t bandHeight) :
+	Adafruit_SharpMem(SCK, MOSI, ss, width, height), m_strip(NULL), m_ss(ss),
+	m_vcom(SHARPMEM_BIT_VCOM), m_byteWidth((width + 7) / 8), m_bandTop(0), m_bandHeight(bandHeight)
+{
+}
+
+SharpStrip::~SharpStrip()
+{
+	delete[] m_strip;
+}
+
+// Allocate the strip, (width / 8) * bandHeight bytes, and start SPI
+boolean SharpStrip::begin(void)
+{
+	if (NULL == m_strip)
+	{
+		m_strip = new uint8_t[m_byteWidth * m_bandHeight];
+	}
+	if (NULL == m_strip)
+	{
+		return false;
+	}
+
+	// Chip select is active high
+	pinMode(m_ss, OUTPUT);
+	digitalWrite(m_ss, LOW);
+	SPI.begin();
+
+	setBand(0, 1); // White
+	return true;
+}
+
+// Only pixels inside the current band are kept
+void SharpStrip::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	y -= m_bandTop;
+	if ((x < 0) || (x >= _width) || (y < 0) || (y >= m_bandHeight))
+	{
+		return;
+	}
+
+	// Same layout as Adafruit_SharpMem, bit set is white, LSB is leftmost
+	uint8_t *data = &m_strip[(y * m_byteWidth) + (x >> 3)];
+	if (color)
+	{
+		*data |= 1 << (x & 7);
+	}
+	else
+	{
+		*data &= ~(1 << (x & 7));
+	}
+}
+
+uint8_t SharpStrip::getPixel(uint16_t x, uint16_t y)
+{
+	y -= m_bandTop;
+	if ((x >= _width) || (y >= m_bandHeight))
+	{
+		return 0;
+	}
+	return m_strip[(y * m_byteWidth) + (x >> 3)] & (1 << (x & 7)) ? 1 : 0;
+}
+
+// Nothing to clear, setBand fills each band before it is drawn.  Sketches
+// call clearDisplay before every updateMenu, and blanking the panel there
+// would flicker each frame.
+void SharpStrip::clearDisplay(void)
+{
+}
+
+// Clear the panel itself
+void SharpStrip::clearPanel(void)
+{
+	SPI.beginTransaction(SPISettings(SHARPMEM_SPI_FREQ, LSBFIRST, SPI_MODE0));
+	digitalWrite(m_ss, HIGH);
+	SPI.transfer(SHARPMEM_BIT_CLEAR | m_vcom);
+	SPI.transfer(0x00);
+	digitalWrite(m_ss, LOW);
+	SPI.endTransaction();
+	toggleVcom();
+}
+
+// Start drawing the band of rows from top, filled with color
+void SharpStrip::setBand(int16_t top, uint16_t color)
+{
+	m_bandTop = top;
+	memset(m_strip, color ? 0xFF : 0x00, m_byteWidth * m_bandHeight);
+}
+
+// Send the rows of the current band to the panel
+void SharpStrip::flushBand(void)
+{
+	int16_t rows = m_bandHeight;
+	if (m_bandTop + rows > _height)
+	{
+		rows = _height - m_bandTop;
+	}
+
+	sharpWriteLines(m_ss, m_vcom, m_bandTop, rows, m_strip, m_byteWidth);
+	toggleVcom();
+}
+
+// Write count lines of byteWidth bytes each from data to the panel,
+// starting at line first (from 0), with one line write command
+void sharpWriteLines(uint8_t ss, uint8_t vcom, int16_t first, int16_t count,
+	const uint8_t *data, uint16_t byteWidth)
+{
+	SPI.beginTransaction(SPISettings(SHARPMEM_SPI_FREQ, LSBFIRST, SPI_MODE0));
+	digitalWrite(ss, HIGH);
+	SPI.transfer(SHARPMEM_BIT_WRITECMD | vcom);
+	for (int16_t row = 0; row < count; row++)
+	{
+		// Lines are numbered from 1
+		SPI.transfer(first + row + 1);
+		for (uint16_t index = 0; index < byteWidth; index++)
+		{
+			SPI.transfer(*data++);
+		}
+		SPI.transfer(0x00);
+	}
+	SPI.transfer(0x00);
+	digitalWrite(ss, LOW);
+	SPI.endTransaction();
+}
+
+void SharpStrip::toggleVcom(void)
+{
+	m_vcom = m_vcom ? 0x00 : SHARPMEM_BIT_VCOM;
+}
@@ -0,0 +1,64 @@
+/*********************************************************************
+This is a library for Watch
+
+Band-by-band driver for large SHARP Memory Displays.  Only a strip of
+bandHeight rows is held in RAM instead of the whole framebuffer, and
+WatchMenu draws the display one band at a time, sending each band with
+line writes as it is finished.  Rotation is not supported.
+
+clearDisplay does nothing, as each band starts filled, so an existing
+loop of clearDisplay, updateMenu and refresh ports unchanged without the
+panel blanking every frame.  clearPanel sends the panel's clear command.
+
+drawPixel is virtual, so GFX drawing works through any reference.
+getPixel, clearDisplay and refresh are not virtual in Adafruit_SharpMem
+and are only hidden here: called through an Adafruit_SharpMem& or * the
+base versions run, on a framebuffer a SharpStrip never allocates.  Call
+them on the SharpStrip itself.
+
+Written by Mark Winney.
+BSD license, check license.txt for more information
+All text above, and the splash screen must be included in any redistribution
+*********************************************************************/
+#ifndef _SHARP_STRIP_H
+#define _SHARP_STRIP_H
+
+#include "Adafruit_SharpMem.h"
+
+class SharpStrip : public Adafruit_SharpMem
+{
+public:
+	SharpStrip(uint8_t ss, uint16_t width, uint16_t height, uint8_t bandHeight);
+	~SharpStrip();
+	boolean begin(void);
+	void drawPixel(int16_t x, int16_t y, uint16_t color);
+	// Not virtual in Adafruit_SharpMem, see above
+	uint8_t getPixel(uint16_t x, uint16_t y);
+	void clearDisplay(void); // Does nothing, see above
+	void refresh(void){}; // Each band is sent by flushBand
+	void clearPanel(void);
+
+	void setBand(int16_t top, uint16_t color);
+	void flushBand(void);
+	int16_t bandTop(){ return m_bandTop; };
+	uint8_t bandHeight(){ return m_bandHeight; };
+
+  private:
+	void toggleVcom(void);
+
+	uint8_t *m_strip; // bandHeight rows of the display
+	uint8_t m_ss;
+	uint8_t m_vcom;
+	uint16_t m_byteWidth;
+	int16_t m_bandTop;
+	uint8_t m_bandHeight;
+};
+
+#define SHARPMEM_BIT_VCOM	0x02	// Toggled after each command
+
+// Line writes from a framebuffer to the panel on the hardware SPI pins,
+// used by SharpStrip for each band and by WatchMenu for popup rows
+void sharpWriteLines(uint8_t ss, uint8_t vcom, int16_t first, int16_t count,
+	const uint8_t *data, uint16_t byteWidth);
+
+#endif
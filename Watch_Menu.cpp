@@ -6,12 +6,17 @@
  All text above, and the splash screen must be included in any redistribution
  *********************************************************************/
 
+// Include the core first, so the checks below keep its PROGMEM macros
+#include "Adafruit_SharpMem.h"
+#include "Watch_Menu.h"
+#if WATCH_MENU_BANDS || WATCH_MENU_OVERLAY
+ #include "Sharp_Strip.h"
+#endif
+
 #ifdef __AVR__
   #include <avr/pgmspace.h>
 #elif defined(ESP8266) || defined(ESP32)
  #include <pgmspace.h>
-#else
- #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
 #endif
 
 #if !defined(__ARM_ARCH) && !defined(ENERGIA) && !defined(ESP8266) && !defined(ESP32) && !defined(__arc__)
@@ -28,17 +33,17 @@
 #endif
 
 // Pointers are a peculiar case...typically 16-bit on AVR boards,
-// 32 bits elsewhere.  Try to accommodate both...
-
-#if !defined(__INT_MAX__) || (__INT_MAX__ > 0xFFFF)
- #define pgm_read_pointer(addr) ((void *)pgm_read_dword(addr))
-#else
- #define pgm_read_pointer(addr) ((void *)pgm_read_word(addr))
+// 32 bits elsewhere.  Try to accommodate both, unless the core already
+// reads a whole pointer (64 bits on a host).
+
+#ifndef pgm_read_pointer
+ #if !defined(__INT_MAX__) || (__INT_MAX__ > 0xFFFF)
+  #define pgm_read_pointer(addr) ((void *)pgm_read_dword(addr))
+ #else
+  #define pgm_read_pointer(addr) ((void *)pgm_read_word(addr))
+ #endif
 #endif
 
-#include "Adafruit_SharpMem.h"
-#include "watch_menu.h"
-
 #define NOINVERT	false
 #define YPOS		64
 
@@ -48,9 +53,31 @@ extern const uint8_t menu_default[];
 extern const uint8_t selectbar_topWidthPixels;
 
 WatchMenu::WatchMenu (Adafruit_SharpMem& display) : m_display (display), m_inverted(false), menus(NULL)
+#if WATCH_MENU_STRTAB
+	, m_strtab(NULL)
+#endif
+#if WATCH_MENU_BANDS
+	, m_strip(NULL)
+#endif
+#if WATCH_MENU_FRAME_CACHE
+	, m_frames(NULL), m_numFrames(0), m_frameBytes(0)
+#endif
+#if WATCH_MENU_OVERLAY
+	, m_overlay(NULL), m_overlayKeep(false), m_overlayClosed(false), m_overlayRows(false), m_vcom(SHARPMEM_BIT_VCOM)
+#endif
+#if WATCH_MENU_ACTIONS
+	, m_stepFunc(NULL), m_actionProgress(0), m_actionBudget(10), m_actionFinished(false)
+#endif
 {
 }
 
+#if WATCH_MENU_BANDS
+WatchMenu::WatchMenu (SharpStrip& display) : WatchMenu ((Adafruit_SharpMem&)display)
+{
+	m_strip = &display;
+}
+#endif
+
 void WatchMenu::setDownFunc(pFunc func)
 {
 	menus[menu_selected]->downFunc = func;
@@ -64,6 +91,8 @@ void WatchMenu::setUpFunc(pFunc func)
 void WatchMenu::setDrawFunc(pFunc func)
 {
 	menus[menu_selected]->drawFunc = func;
+	invalidateFrameCache(menu_selected);
+	menuChanged();
 }
 
 bool WatchMenu::menuDown(void)
@@ -133,6 +162,34 @@ bool WatchMenu::selectOption (void)
   pFunc funct = menus[menu_selected]->options[optSel]->func;
   bool subMenu = (funct == NULL);
 
+#if WATCH_MENU_ACTIONS
+  // Resumable actions are started here and stepped by updateMenu
+  pStepFunc stepFunc = menus[menu_selected]->options[optSel]->stepFunc;
+#if WATCH_MENU_COROUTINES
+  pTaskFunc taskFunc = menus[menu_selected]->options[optSel]->taskFunc;
+#else
+  void *taskFunc = NULL;
+#endif
+  if (stepFunc != NULL || taskFunc != NULL)
+  {
+	  // Only one action runs at a time
+	  if (actionRunning())
+	  {
+		  return false;
+	  }
+	  m_actionProgress = 0;
+	  m_actionFinished = false;
+	  m_stepFunc = stepFunc;
+#if WATCH_MENU_COROUTINES
+	  if (taskFunc != NULL)
+	  {
+		  m_task = taskFunc();
+	  }
+#endif
+	  return true;
+  }
+#endif
+
   if (subMenu == true)
   {
     // Get the index to the sub menu
@@ -201,7 +258,10 @@ void WatchMenu::createMenu (int8_t index, int8_t num_options, const char *name,
 	{
 		menus[index] = new s_menu; // allocate space for the menu
 	}
-	strcpy_P(menus[index]->name, name);
+	menus[index]->name = name;
+#if WATCH_MENU_STRTAB
+	menus[index]->name_id = STR_NONE;
+#endif
 	menus[index]->options = new s_option*[num_options]; // Allocate array of pointers to options
 	menus[index]->num_options = num_options;
 	menus[index]->option_selected = 0;
@@ -218,8 +278,30 @@ void WatchMenu::createMenu (int8_t index, int8_t num_options, const char *name,
 
 	// Set the start animination point...number of icons - 1 * icon width
 	menus[index]->animX = m_display.width() / 2;
+
+	invalidateFrameCache(index);
+	menuChanged();
 }
 
+#if WATCH_MENU_ACTIONS
+void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *name,
+			const uint8_t *icon, pStepFunc stepFunc)
+{
+	createOption (menu_index, opt_index, name, icon, (pFunc)NULL);
+	menus[menu_index]->options[opt_index]->stepFunc = stepFunc;
+}
+#endif
+
+#if WATCH_MENU_COROUTINES
+void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *name,
+			const uint8_t *icon, pTaskFunc taskFunc)
+{
+	createOption (menu_index, opt_index, name, icon, (pFunc)NULL);
+	menus[menu_index]->options[opt_index]->taskFunc = taskFunc;
+}
+#endif
+
+#if WATCH_MENU_INVERT
 void WatchMenu::createOption (int8_t menu_index, int8_t opt_index,
 	int16_t invert_start, int16_t invert_length, const char *name,
 	const uint8_t *icon, pFunc actionFunc)
@@ -227,7 +309,10 @@ void WatchMenu::createOption (int8_t menu_index, int8_t opt_index,
 	createOption (menu_index, opt_index, name, icon, actionFunc);
 	menus[menu_index]->options[opt_index]->invert_start = invert_start;
 	menus[menu_index]->options[opt_index]->invert_length = invert_length;
+	invalidateFrameCache(menu_index);
+	menuChanged();
 }
+#endif
 
 void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *name,
 			const uint8_t *icon, pFunc actionFunc)
@@ -239,10 +324,24 @@ void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *n
 
 	menus[menu_index]->options[opt_index]->func = actionFunc;
 	menus[menu_index]->options[opt_index]->icon = icon;
-	strcpy_P(menus[menu_index]->options[opt_index]->name, name);
+	menus[menu_index]->options[opt_index]->name = name;
+#if WATCH_MENU_STRTAB
+	menus[menu_index]->options[opt_index]->name_id = STR_NONE;
+#endif
 	menus[menu_index]->options[opt_index]->menu_index = -1;
+#if WATCH_MENU_INVERT
 	menus[menu_index]->options[opt_index]->invert_start = -1;
 	menus[menu_index]->options[opt_index]->invert_length = 0;
+#endif
+#if WATCH_MENU_ACTIONS
+	menus[menu_index]->options[opt_index]->stepFunc = NULL;
+#endif
+#if WATCH_MENU_COROUTINES
+	menus[menu_index]->options[opt_index]->taskFunc = NULL;
+#endif
+
+	invalidateFrameCache(menu_index);
+	menuChanged();
 }
 
 void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *name,
@@ -254,10 +353,24 @@ void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *n
 	}
 	menus[menu_index]->options[opt_index]->func = NULL;
 	menus[menu_index]->options[opt_index]->icon = icon;
-	strcpy_P(menus[menu_index]->options[opt_index]->name, name);
+	menus[menu_index]->options[opt_index]->name = name;
+#if WATCH_MENU_STRTAB
+	menus[menu_index]->options[opt_index]->name_id = STR_NONE;
+#endif
 	menus[menu_index]->options[opt_index]->menu_index = prev_menu_index;
+#if WATCH_MENU_INVERT
 	menus[menu_index]->options[opt_index]->invert_start = -1;
 	menus[menu_index]->options[opt_index]->invert_length = 0;
+#endif
+#if WATCH_MENU_ACTIONS
+	menus[menu_index]->options[opt_index]->stepFunc = NULL;
+#endif
+#if WATCH_MENU_COROUTINES
+	menus[menu_index]->options[opt_index]->taskFunc = NULL;
+#endif
+
+	invalidateFrameCache(menu_index);
+	menuChanged();
 }
 
 void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, pFunc actionFunc,
@@ -267,11 +380,26 @@ void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, pFunc actionF
 	{
 		menus[menu_index]->options[opt_index] = new s_option; // allocate space for the option
 	}
-	menus[menu_index]->options[opt_index] = new s_option; // allocate space for the option
 	menus[menu_index]->options[opt_index]->func = actionFunc;
+	menus[menu_index]->options[opt_index]->icon = NULL;
+	menus[menu_index]->options[opt_index]->name = NULL;
+#if WATCH_MENU_STRTAB
+	menus[menu_index]->options[opt_index]->name_id = STR_NONE;
+#endif
 	menus[menu_index]->options[opt_index]->menu_index = prev_menu_index;
+#if WATCH_MENU_INVERT
 	menus[menu_index]->options[opt_index]->invert_start = -1;
 	menus[menu_index]->options[opt_index]->invert_length = 0;
+#endif
+#if WATCH_MENU_ACTIONS
+	menus[menu_index]->options[opt_index]->stepFunc = NULL;
+#endif
+#if WATCH_MENU_COROUTINES
+	menus[menu_index]->options[opt_index]->taskFunc = NULL;
+#endif
+
+	invalidateFrameCache(menu_index);
+	menuChanged();
 }
 
 void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *name,
@@ -281,25 +409,36 @@ void WatchMenu::createOption (int8_t menu_index, int8_t opt_index, const char *n
 	{
 		menus[menu_index]->options[opt_index] = new s_option; // allocate space for the option
 	}
-	menus[menu_index]->options[opt_index] = new s_option; // allocate space for the option
-	strcpy_P(menus[menu_index]->options[opt_index]->name, name);
+	menus[menu_index]->options[opt_index]->func = NULL;
+	menus[menu_index]->options[opt_index]->icon = NULL;
+	menus[menu_index]->options[opt_index]->name = name;
+#if WATCH_MENU_STRTAB
+	menus[menu_index]->options[opt_index]->name_id = STR_NONE;
+#endif
 	menus[menu_index]->options[opt_index]->menu_index = prev_menu_index;
+#if WATCH_MENU_INVERT
 	menus[menu_index]->options[opt_index]->invert_start = -1;
 	menus[menu_index]->options[opt_index]->invert_length = 0;
+#endif
+#if WATCH_MENU_ACTIONS
+	menus[menu_index]->options[opt_index]->stepFunc = NULL;
+#endif
+#if WATCH_MENU_COROUTINES
+	menus[menu_index]->options[opt_index]->taskFunc = NULL;
+#endif
+
+	invalidateFrameCache(menu_index);
+	menuChanged();
 }
 
+#if WATCH_MENU_STR
 void WatchMenu::menu_drawStr()
 {
 	const int16_t displayWidth = m_display.width();
-	const int16_t displayHeight = m_display.height();
 
-	// Copy the data from PROGMEM...max 20 chars
-	char tmpStr[20] = { 0 };
-	strcpy_P (tmpStr, menus[menu_selected]->name);
 	// Calculate Y position using the height of the font.
-
 	uint8_t h = fontHeight() + (fontHeight() / 2);  // Add some spacing
-	drawCentreString(tmpStr, displayWidth / 2, YPOS + h, textSize);
+	drawCentreName(nameOf(menus[menu_selected]), displayWidth / 2, YPOS + h);
 
 	byte count = menus[menu_selected]->num_options;
 	byte opt = 0;
@@ -307,106 +446,228 @@ void WatchMenu::menu_drawStr()
 	// right of the display
 	for(; opt < count - 1; opt++)
 	{
-		char tmpStr[20] = { 0 };
-		if (NULL != menus[menu_selected]->options[opt])
-		{
-			if(opt == menus[menu_selected]->option_selected)
-			{
-				drawString(">", 0, YPOS + (h * (opt + 2)));
-			}
-			const char *str = menus[menu_selected]->options[opt]->name;
-			strcpy_P (tmpStr, str);
-		}
-
-		// See about inverting some text
-		int16_t invStart = menus[menu_selected]->options[opt]->invert_start;
-		int16_t invLen = menus[menu_selected]->options[opt]->invert_length;
-
-
-		if (invStart >= 0)
+		s_option *option = menus[menu_selected]->options[opt];
+		if (NULL == option)
 		{
-			// Split the string into 3 parts around the invertion
-			char tmpStartStr[20] = { 0 };
-			strncpy_P(tmpStartStr, tmpStr, invStart);
-			char tmpInvertStr[20] = { 0 };
-			strncpy_P(tmpInvertStr, tmpStr + invStart, invLen);
-			char tmpEndStr[20] = { 0 };
-			strcpy_P(tmpEndStr, tmpStr + invStart + invLen);
-			int16_t ypos = YPOS + (h * (opt + 2));
-			int16_t xpos = fontWidth();
-
-			drawString(tmpStartStr, xpos, ypos);
-			xpos += fontWidth() * strlen(tmpStartStr);
-			// Display background
-        	m_display.fillRect(xpos, ypos - (fontHeight() +  1), fontWidth() * invLen, fontHeight() +  3, m_inverted ? WHITE : BLACK);
-
-			// invert the text.
-			m_inverted = !m_inverted;
-			drawString(tmpInvertStr, xpos, ypos);
-			m_inverted = !m_inverted;
-			xpos += fontWidth() * strlen(tmpInvertStr);
-			drawString(tmpEndStr, xpos, ypos);
+			continue;
 		}
-		else
+		if(opt == menus[menu_selected]->option_selected)
 		{
-			drawString(tmpStr, fontWidth(), YPOS + (h * (opt + 2)));
+			drawString(">", 0, YPOS + (h * (opt + 2)));
 		}
+
+#if WATCH_MENU_INVERT
+		// See about inverting some text
+		drawName(nameOf(option), fontWidth(), YPOS + (h * (opt + 2)),
+			option->invert_start, option->invert_length);
+#else
+		drawName(nameOf(option), fontWidth(), YPOS + (h * (opt + 2)));
+#endif
 	}
 
 	// Display the exit at right side of the screen
-	const char *str = menus[menu_selected]->options[opt]->name;
-	uint8_t exitStrLen = strlen(str) + 2; // Add 1 for the leading '>' and 1 for space at end
+	s_name str = nameOf(menus[menu_selected]->options[opt]);
+	uint8_t exitStrLen = nameLength(str) + 2; // Add 1 for the leading '>' and 1 for space at end
 	uint16_t xpos = m_display.width() - (exitStrLen * fontWidth());
 
 	if(opt == menus[menu_selected]->option_selected)
 	{
 		drawString(">", xpos, YPOS + (h * (opt + 1)));
 	}
-	strcpy_P (tmpStr, str);
-	drawString(tmpStr, xpos + fontWidth(), YPOS + (h * (opt + 1)));
+	drawName(str, xpos + fontWidth(), YPOS + (h * (opt + 1)));
 }
+#endif
 bool WatchMenu::updateMenu()
 {
+#if WATCH_MENU_FONTS
 	m_display.setFont(m_font);
+#endif
 
 	bool bAnimating = false;
 
-	if ( MENU_TYPE_STR == menus[menu_selected]->type)
+#if WATCH_MENU_ACTIONS
+	// Give the running action its slice of time before drawing.  One more
+	// update is asked for after it finishes, to clear its ACTION_DONE.
+	bool bRunning = runAction() || m_actionFinished;
+#endif
+
+#if WATCH_MENU_OVERLAY
+	// Leave the menu under the popup alone, and the menu put back by
+	// closeOverlay.  The drawFunc still draws the popup.
+	bool bKept = menuKept();
+	m_overlayClosed = false;
+	if (!bKept)
 	{
-		menu_drawStr();
+		// The whole display is drawn again, so needs a refresh()
+		m_overlayRows = false;
 	}
-	else
+	if (bKept)
 	{
-		// Get the index to the sub menu
-		int8_t optSel = menus[menu_selected]->option_selected;
-		int8_t menuIndex = menus[menu_selected]->options[optSel]->menu_index;
+		if(menus[menu_selected]->drawFunc != NULL)
+		{
+			menus[menu_selected]->drawFunc();
+		}
+#if WATCH_MENU_ACTIONS
+		return bRunning;
+#else
+		return false;
+#endif
+	}
+#endif
+
+	bAnimating = animateMenu();
 
+#if WATCH_MENU_BANDS
+	if (NULL != m_strip)
+	{
+		// Lay the whole menu out again for each band of rows, only the
+		// band is kept in RAM
+		for (int16_t top = 0; top < m_display.height(); top += m_strip->bandHeight())
 		{
-			// Display as regular icon
-			// Get the first menu to start with...change later to get current
-			bAnimating = menu_drawIcon();
+			m_strip->setBand(top, m_inverted ? BLACK : WHITE);
+			renderMenu();
+			if(menus[menu_selected]->drawFunc != NULL)
+			{
+				menus[menu_selected]->drawFunc();
+			}
+			m_strip->flushBand();
 		}
 	}
-	// Draw stuff
-	if(menus[menu_selected]->drawFunc != NULL)
+	else
+#endif
 	{
-		menus[menu_selected]->drawFunc();
+#if WATCH_MENU_FRAME_CACHE
+		// A settled screen that was rendered before is just copied back
+		s_frame *frame = findFrame();
+		if (NULL != frame)
+		{
+			memcpy(displayBuffer(), frame->buffer, m_frameBytes);
+		}
+		else
+		{
+			renderMenu();
+			if (!bAnimating)
+			{
+				storeFrame();
+			}
+		}
+#else
+		renderMenu();
+#endif
+
+		// Draw stuff.  Not part of the cached frame as it is usually dynamic
+		if(menus[menu_selected]->drawFunc != NULL)
+		{
+			menus[menu_selected]->drawFunc();
+		}
+
+#if WATCH_MENU_OVERLAY
+		// The menu now on the display, for a popup to save and put back
+		m_overlayKeep = true;
+		m_keptMenu = menu_selected;
+		m_keptOption = menus[menu_selected]->option_selected;
+		m_keptAnimX = menus[menu_selected]->animX;
+		m_keptInverted = m_inverted;
+#endif
 	}
+#if WATCH_MENU_ACTIONS
+	// Keep the caller updating until the action has finished
+	bAnimating |= bRunning;
+#endif
   return bAnimating;
 }
 
+// Advance any animation by one frame, returns true while animating
+bool WatchMenu::animateMenu()
+{
+#if WATCH_MENU_STR && WATCH_MENU_ICON
+	if ( MENU_TYPE_STR == menus[menu_selected]->type)
+	{
+		return false;
+	}
+	return menu_animateIcon();
+#elif WATCH_MENU_STR
+	return false;
+#else
+	return menu_animateIcon();
+#endif
+}
+
+// Draw the menu as it is now, without moving any animation on
+void WatchMenu::renderMenu()
+{
+#if WATCH_MENU_STR && WATCH_MENU_ICON
+	if ( MENU_TYPE_STR == menus[menu_selected]->type)
+	{
+		menu_drawStr();
+	}
+	else
+	{
+		// Display as regular icon
+		menu_renderIcon();
+	}
+#elif WATCH_MENU_STR
+	menu_drawStr();
+#else
+	menu_renderIcon();
+#endif
+}
+
+// True if rows y to y + h - 1 are in the band being drawn.  Always true
+// when the whole display is drawn at once.
+bool WatchMenu::inBand(int16_t y, int16_t h)
+{
+#if WATCH_MENU_BANDS
+	if (NULL != m_strip)
+	{
+		return (y + h > m_strip->bandTop()) && (y < m_strip->bandTop() + m_strip->bandHeight());
+	}
+#endif
+	return true;
+}
+
+// Top row of the band being drawn, 0 when the whole display is drawn at once
+int16_t WatchMenu::bandTop(void)
+{
+#if WATCH_MENU_BANDS
+	if (NULL != m_strip)
+	{
+		return m_strip->bandTop();
+	}
+#endif
+	return 0;
+}
+
+// Text can sit above or below the cursor depending on the font, so allow
+// a line either side
+bool WatchMenu::textInBand(int16_t y)
+{
+	int16_t h = (m_fontHeight + 2) * (textSize ? textSize : 1);
+	return inBand(y - h, 2 * h);
+}
+
+#if WATCH_MENU_ICON
 bool WatchMenu::menu_drawIcon()
 {
-  const int16_t displayWidth = m_display.width();
-  const int16_t displayHeight = m_display.height();
+  bool bAnimating = menu_animateIcon();
+  menu_renderIcon();
+  return bAnimating;
+}
 
+bool WatchMenu::menu_animateIcon()
+{
   bool bAnimating = true;
 
 //	int x = 64;
-  int x = displayWidth / 2;
+  int x = m_display.width() / 2;
   x -= 48 * menus[menu_selected]->option_selected;
 
   int16_t *animX = &menus[menu_selected]->animX;
+#if !WATCH_MENU_ANIMATE
+  // No carousel animation, jump straight to the option
+  *animX = x;
+  bAnimating = false;
+#else
   {
     int8_t speed;
     if (x > *animX)
@@ -432,20 +693,23 @@ bool WatchMenu::menu_drawIcon()
       bAnimating = false;
     }
   }
+#endif
+
+  return bAnimating;
+}
 
-  x = *animX - 16;
+void WatchMenu::menu_renderIcon()
+{
+  const int16_t displayWidth = m_display.width();
+  int x = menus[menu_selected]->animX - 16;
 
-  // Copy the data from PROGMEM...max 20 chars
-  char tmpStr[20] = { 0 };
-  strcpy_P (tmpStr, menus[menu_selected]->name);
-  int16_t tempX;
-  int16_t tempY;
   uint16_t w;
   uint16_t h;
 
   // Get the string height specifically.
-  m_display.getTextBounds(tmpStr, 0, 0, &tempX, &tempY, &w, &h);
-  drawCentreString(tmpStr, displayWidth / 2, YPOS + h, textSize);
+  s_name name = nameOf(menus[menu_selected]);
+  nameBounds(name, &w, &h);
+  drawCentreName(name, displayWidth / 2, YPOS + h);
 
   // Create image struct
   // FIX: struct uses heap, should use stack
@@ -454,21 +718,28 @@ bool WatchMenu::menu_drawIcon()
 			 YPOS + 14, selectbar_top, fix, 8, m_inverted ? WHITE : BLACK, NOINVERT);
 
   // Draw ...
-  ultraFastDrawBitmap (&img);
+  if (inBand(img.y, img.height))
+  {
+    ultraFastDrawBitmap (&img);
+  }
 
   // Draw ...
   img.y = YPOS + 42;
   img.bitmap = selectbar_bottom;
-  ultraFastDrawBitmap(&img);
+  if (inBand(img.y, img.height))
+  {
+    ultraFastDrawBitmap(&img);
+  }
 
   img.y = YPOS + 16;
   img.width = 32;
   img.height = 32;
 
   // Display each menu option
+  bool iconsInBand = inBand(img.y, img.height);
   for (byte i = 0; i < menus[menu_selected]->num_options; i++)
   {
-    if (x < displayWidth && x > -32)
+    if (iconsInBand && x < displayWidth && x > -32)
     {
       img.x = x;
       img.bitmap =
@@ -480,14 +751,14 @@ bool WatchMenu::menu_drawIcon()
   }
 
   uint8_t sel_opt = menus[menu_selected]->option_selected;
-  strcpy_P (tmpStr, menus[menu_selected]->options[sel_opt]->name);
+  name = nameOf(menus[menu_selected]->options[sel_opt]);
   // Get the string height specifically.
-  m_display.getTextBounds(tmpStr, 0, 0, &tempX, &tempY, &w, &h);
-  drawCentreString(tmpStr, displayWidth / 2, YPOS + 64 - (h / 2), textSize);
-
-  return bAnimating;
+  nameBounds(name, &w, &h);
+  drawCentreName(name, displayWidth / 2, YPOS + 64 - (h / 2));
 }
 
+#endif
+
 void WatchMenu::ultraFastDrawBitmap (s_image* image)
 {
   m_display.drawBitmap(image->x, image->y, image->bitmap, image->width, image->height, image->foreColour);
@@ -506,10 +777,20 @@ void WatchMenu::resetMenu ()
   }
 }
 
+// A menu's text or layout changed, so the menu last drawn, and saved
+// under any popup, can't be put back as it is
+void WatchMenu::menuChanged(void)
+{
+#if WATCH_MENU_OVERLAY
+	m_overlayKeep = false;
+#endif
+}
+
 void WatchMenu::setTextSize (uint8_t size)
 {
 	m_display.setTextSize(size);
 	textSize = size;
+	menuChanged();
 }
 
 /***************************************************************************************
@@ -518,6 +799,11 @@ void WatchMenu::setTextSize (uint8_t size)
 ***************************************************************************************/
 void WatchMenu::drawCentreString(char *str, int dX, int poY, int size)
 {
+	if (!textInBand(poY))
+	{
+		return;
+	}
+
 	int16_t tempX;
 	int16_t tempY;
 	uint16_t w;
@@ -533,11 +819,241 @@ void WatchMenu::drawCentreString(char *str, int dX, int poY, int size)
 
 void WatchMenu::drawString(char* str, byte x, byte y)
 {
+	if (!textInBand(y))
+	{
+		return;
+	}
+
 	m_display.setTextColor(m_inverted ? WHITE : BLACK, m_inverted ? BLACK : WHITE);
 	m_display.setCursor(x, y);
 	m_display.print(str);
 }
 
+// Start decoding a menu name, from the current string table if it has an id
+s_name WatchMenu::nameOf(s_menu *menu)
+{
+	s_name name = { (const uint8_t *)menu->name, NULL };
+#if WATCH_MENU_STRTAB
+	if (STR_NONE != menu->name_id)
+	{
+		name.str = NULL;
+		if (NULL != m_strtab && menu->name_id < m_strtab->num_strings)
+		{
+			name.str = m_strtab->strings + pgm_read_word(&m_strtab->string_index[menu->name_id]);
+			name.table = true;
+		}
+	}
+#endif
+	return name;
+}
+
+s_name WatchMenu::nameOf(s_option *option)
+{
+	s_name name = { (const uint8_t *)option->name, NULL };
+#if WATCH_MENU_STRTAB
+	if (STR_NONE != option->name_id)
+	{
+		name.str = NULL;
+		if (NULL != m_strtab && option->name_id < m_strtab->num_strings)
+		{
+			name.str = m_strtab->strings + pgm_read_word(&m_strtab->string_index[option->name_id]);
+			name.table = true;
+		}
+	}
+#endif
+	return name;
+}
+
+// Next character of a name, expanding dictionary words in table strings.
+// Plain names are drawn as they are.  Returns 0 at the end of the name.
+char WatchMenu::nameChar(s_name *name)
+{
+	if (NULL != name->word)
+	{
+		char c = pgm_read_byte(name->word++);
+		if (c != 0)
+		{
+			return c;
+		}
+		name->word = NULL;
+#if WATCH_MENU_STRTAB
+		// Two words in a row have a space between them
+		uint8_t next = pgm_read_byte(name->str);
+		if ((next & 0x80) && STRTAB_ESCAPE != next && (next & 0x7F) < m_strtab->dict_size)
+		{
+			return ' ';
+		}
+#endif
+	}
+	if (NULL == name->str)
+	{
+		return 0;
+	}
+
+	uint8_t c = pgm_read_byte(name->str);
+	if (c == 0)
+	{
+		return 0;
+	}
+	name->str++;
+#if WATCH_MENU_STRTAB
+	if (name->table && (c & 0x80))
+	{
+		if (STRTAB_ESCAPE == c)
+		{
+			c = pgm_read_byte(name->str);
+			if (c != 0)
+			{
+				name->str++;
+			}
+			return c;
+		}
+		if ((c & 0x7F) < m_strtab->dict_size)
+		{
+			name->word = m_strtab->dict + pgm_read_word(&m_strtab->dict_index[c & 0x7F]);
+		}
+		return nameChar(name);
+	}
+#endif
+	return c;
+}
+
+uint8_t WatchMenu::nameLength(s_name name)
+{
+	uint8_t len = 0;
+
+	while (nameChar(&name) != 0)
+	{
+		len++;
+	}
+	return len;
+}
+
+// Same as getTextBounds, without decoding the name into RAM first
+void WatchMenu::nameBounds(s_name name, uint16_t *w, uint16_t *h)
+{
+	const uint8_t size = textSize ? textSize : 1;
+	char c;
+
+	if (NULL == m_font)
+	{
+		// Built in font, every character is 6x8
+		uint8_t len = nameLength(name);
+		*w = len * 6 * size;
+		*h = len ? 8 * size : 0;
+		return;
+	}
+
+	uint8_t first = pgm_read_byte(&m_font->first);
+	uint8_t last = pgm_read_byte(&m_font->last);
+	GFXglyph *glyphs = (GFXglyph *)pgm_read_pointer(&m_font->glyph);
+	int16_t x = 0;
+	int16_t minx = 0x7FFF;
+	int16_t miny = 0x7FFF;
+	int16_t maxx = -1;
+	int16_t maxy = -1;
+
+	while ((c = nameChar(&name)) != 0)
+	{
+		uint8_t ch = (uint8_t)c;
+		if (ch < first || ch > last)
+		{
+			continue;
+		}
+		GFXglyph *glyph = &glyphs[ch - first];
+		uint8_t gw = pgm_read_byte(&glyph->width);
+		uint8_t gh = pgm_read_byte(&glyph->height);
+		int8_t xo = pgm_read_byte(&glyph->xOffset);
+		int8_t yo = pgm_read_byte(&glyph->yOffset);
+		if (gw > 0 && gh > 0)
+		{
+			int16_t x1 = x + (xo * size);
+			int16_t y1 = yo * size;
+			int16_t x2 = x1 + (gw * size) - 1;
+			int16_t y2 = y1 + (gh * size) - 1;
+			if (x1 < minx) minx = x1;
+			if (y1 < miny) miny = y1;
+			if (x2 > maxx) maxx = x2;
+			if (y2 > maxy) maxy = y2;
+		}
+		x += pgm_read_byte(&glyph->xAdvance) * size;
+	}
+
+	*w = (maxx >= minx) ? (maxx - minx + 1) : 0;
+	*h = (maxy >= miny) ? (maxy - miny + 1) : 0;
+}
+
+// Draw a name straight to the display, a character at a time.
+// invLen characters from invStart are drawn inverted.
+void WatchMenu::drawName(s_name name, int16_t x, int16_t y, int16_t invStart, int16_t invLen)
+{
+	if (!textInBand(y))
+	{
+		return;
+	}
+
+	int16_t index = 0;
+	char c;
+
+	m_display.setTextColor(m_inverted ? WHITE : BLACK, m_inverted ? BLACK : WHITE);
+	m_display.setCursor(x, y);
+	while ((c = nameChar(&name)) != 0)
+	{
+		if (index == invStart)
+		{
+			// Display background
+			m_display.fillRect(m_display.getCursorX(), y - (fontHeight() +  1), fontWidth() * invLen, fontHeight() +  3, m_inverted ? WHITE : BLACK);
+			// invert the text.
+			m_display.setTextColor(m_inverted ? BLACK : WHITE, m_inverted ? WHITE : BLACK);
+		}
+		if (index == invStart + invLen)
+		{
+			m_display.setTextColor(m_inverted ? WHITE : BLACK, m_inverted ? BLACK : WHITE);
+		}
+		m_display.write(c);
+		index++;
+	}
+}
+
+void WatchMenu::drawCentreName(s_name name, int dX, int poY)
+{
+	if (!textInBand(poY))
+	{
+		return;
+	}
+
+	uint16_t w;
+	uint16_t h;
+	nameBounds(name, &w, &h);
+	drawName(name, dX - w / 2, poY);
+}
+
+#if WATCH_MENU_STRTAB
+void WatchMenu::setStringTable(const s_strtab *table)
+{
+	m_strtab = table;
+	invalidateFrameCache();
+	menuChanged();
+}
+
+void WatchMenu::setMenuName(int8_t menu_index, uint16_t id)
+{
+	menus[menu_index]->name = NULL;
+	menus[menu_index]->name_id = id;
+	invalidateFrameCache(menu_index);
+	menuChanged();
+}
+
+void WatchMenu::setOptionName(int8_t menu_index, int8_t opt_index, uint16_t id)
+{
+	menus[menu_index]->options[opt_index]->name = NULL;
+	menus[menu_index]->options[opt_index]->name_id = id;
+	invalidateFrameCache(menu_index);
+	menuChanged();
+}
+#endif
+
+#if WATCH_MENU_FONTS
 void WatchMenu::setFont(const GFXfont *font)
 {
 	m_display.setFont(font);
@@ -553,12 +1069,14 @@ void WatchMenu::setFont(const GFXfont *font)
 	// Get the string width
 	m_display.getTextBounds(PSTR("A"), 0, 0, &tempX, &tempY, &w, &h);
 	m_fontHeight = h;
+	menuChanged();
 }
 
 GFXfont *WatchMenu::getFont(void)
 {
 	return m_font;
 }
+#endif
 
 void WatchMenu::selectedOption(int8_t menu_index, int8_t option_index)
 {
@@ -568,4 +1086,447 @@ void WatchMenu::selectedOption(int8_t menu_index, int8_t option_index)
 void WatchMenu::invertDisplay(bool state)
 {
 	m_inverted = state;
-}
\ No newline at end of file
+}
+
+#if WATCH_MENU_FRAME_CACHE || WATCH_MENU_OVERLAY
+#if WATCH_MENU_SHARPMEM_BUFFER
+// Adafruit_SharpMem keeps its framebuffer private.  An explicit template
+// instantiation may name a private member, so the one below hands the
+// member pointer to sharpMemBuffer().  Frames and the rows under a popup
+// are then copied with memcpy, not pixel by pixel.
+typedef uint8_t *Adafruit_SharpMem::*SharpMemMember;
+SharpMemMember sharpMemBuffer(void);
+
+template <SharpMemMember member>
+struct SharpMemBuffer
+{
+	friend SharpMemMember sharpMemBuffer(void)
+	{
+		return member;
+	}
+};
+template struct SharpMemBuffer<&Adafruit_SharpMem::sharpmem_buffer>;
+#endif
+
+// NULL before the display's begin(), or with no direct access
+uint8_t *WatchMenu::displayBuffer()
+{
+#if WATCH_MENU_SHARPMEM_BUFFER
+	return m_display.*sharpMemBuffer();
+#else
+	return NULL;
+#endif
+}
+
+// A menu is only static once any carousel has reached the selected option
+bool WatchMenu::menuSettled()
+{
+#if WATCH_MENU_ICON
+#if WATCH_MENU_STR
+	if (MENU_TYPE_STR == menus[menu_selected]->type)
+	{
+		return true;
+	}
+#endif
+	int16_t x = (m_display.width() / 2) - (48 * menus[menu_selected]->option_selected);
+	return menus[menu_selected]->animX == x;
+#else
+	return true;
+#endif
+}
+#endif
+
+#if WATCH_MENU_FRAME_CACHE
+// Allocate a cache for up to num_frames whole screens, using no more
+// than max_bytes.  Each frame costs (width / 8) * height bytes and is a
+// straight copy of the display's framebuffer, so anything drawn before
+// updateMenu is cached with the menu.
+void WatchMenu::initFrameCache(uint8_t num_frames, uint16_t max_bytes)
+{
+	// Release any previous cache
+	for (uint8_t index = 0; index < m_numFrames; index++)
+	{
+		delete[] m_frames[index].buffer;
+	}
+	delete[] m_frames;
+	m_frames = NULL;
+	m_numFrames = 0;
+
+#if !WATCH_MENU_SHARPMEM_BUFFER
+	// Frames are only kept when they can be copied straight from the
+	// framebuffer; drawing them back a pixel at a time is no faster than
+	// rendering the menu again
+	return;
+#endif
+	m_frameBytes = ((uint32_t)m_display.width() * m_display.height()) / 8;
+	if (m_frameBytes == 0)
+	{
+		return;
+	}
+#if WATCH_MENU_BANDS
+	// There is no whole framebuffer to copy frames from when drawing in bands
+	if (NULL != m_strip)
+	{
+		return;
+	}
+#endif
+
+	if (num_frames > max_bytes / m_frameBytes)
+	{
+		num_frames = max_bytes / m_frameBytes;
+	}
+	if (num_frames == 0)
+	{
+		return;
+	}
+
+	m_frames = new s_frame[num_frames];
+	for (uint8_t index = 0; index < num_frames; index++)
+	{
+		m_frames[index].buffer = new uint8_t[m_frameBytes];
+		if (NULL == m_frames[index].buffer)
+		{
+			break;
+		}
+		m_frames[index].valid = false;
+		m_frames[index].age = index;
+		m_numFrames++;
+	}
+}
+
+void WatchMenu::invalidateFrameCache(void)
+{
+	for (uint8_t index = 0; index < m_numFrames; index++)
+	{
+		m_frames[index].valid = false;
+	}
+}
+
+void WatchMenu::invalidateFrameCache(int8_t menu_index)
+{
+	for (uint8_t index = 0; index < m_numFrames; index++)
+	{
+		if (m_frames[index].menu_index == menu_index)
+		{
+			m_frames[index].valid = false;
+		}
+	}
+}
+
+s_frame *WatchMenu::findFrame()
+{
+	// Nothing to copy to before the display's begin()
+	if (NULL == displayBuffer() || !menuSettled())
+	{
+		return NULL;
+	}
+
+	for (uint8_t index = 0; index < m_numFrames; index++)
+	{
+		s_frame *frame = &m_frames[index];
+		if (frame->valid &&
+			frame->menu_index == menu_selected &&
+			frame->option_selected == menus[menu_selected]->option_selected &&
+			frame->font == m_font &&
+			frame->textSize == textSize &&
+			frame->inverted == m_inverted)
+		{
+			// Make this the most recently used
+			for (uint8_t other = 0; other < m_numFrames; other++)
+			{
+				if (m_frames[other].age < frame->age)
+				{
+					m_frames[other].age++;
+				}
+			}
+			frame->age = 0;
+			return frame;
+		}
+	}
+	return NULL;
+}
+
+void WatchMenu::storeFrame()
+{
+	if (0 == m_numFrames || NULL == displayBuffer())
+	{
+		return;
+	}
+
+	// Replace the least recently used frame
+	s_frame *frame = &m_frames[0];
+	for (uint8_t index = 1; index < m_numFrames; index++)
+	{
+		if (m_frames[index].age > frame->age)
+		{
+			frame = &m_frames[index];
+		}
+	}
+	for (uint8_t index = 0; index < m_numFrames; index++)
+	{
+		m_frames[index].age++;
+	}
+
+	memcpy(frame->buffer, displayBuffer(), m_frameBytes);
+	frame->valid = true;
+	frame->menu_index = menu_selected;
+	frame->option_selected = menus[menu_selected]->option_selected;
+	frame->font = m_font;
+	frame->textSize = textSize;
+	frame->inverted = m_inverted;
+	frame->age = 0;
+}
+
+#endif
+
+#if WATCH_MENU_OVERLAY
+// Save the framebuffer rows under the popup rectangle and clear it ready
+// for the popup to be drawn.  Returns false if a popup is already open or
+// there is no memory to save the rows.
+bool WatchMenu::openOverlay(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	if (NULL != m_overlay)
+	{
+		return false;
+	}
+#if WATCH_MENU_SHARPMEM_BUFFER
+	if (NULL == displayBuffer())
+	{
+		return false;
+	}
+#endif
+#if WATCH_MENU_BANDS
+	// The display under the popup is not kept when drawing in bands
+	if (NULL != m_strip)
+	{
+		return false;
+	}
+#endif
+
+	// Keep the rectangle on the display
+	if (x < 0)
+	{
+		w += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		h += y;
+		y = 0;
+	}
+	if (x + w > m_display.width())
+	{
+		w = m_display.width() - x;
+	}
+	if (y + h > m_display.height())
+	{
+		h = m_display.height() - y;
+	}
+	if (w <= 0 || h <= 0)
+	{
+		return false;
+	}
+
+#if WATCH_MENU_SHARPMEM_BUFFER
+	// The framebuffer is in rows of the panel before rotation
+	int16_t row;
+	int16_t rows;
+	int16_t panelRows;
+	switch (m_display.getRotation())
+	{
+		case 1:
+			row = x;
+			rows = w;
+			panelRows = m_display.width();
+			break;
+		case 2:
+			row = m_display.height() - y - h;
+			rows = h;
+			panelRows = m_display.height();
+			break;
+		case 3:
+			row = m_display.width() - x - w;
+			rows = w;
+			panelRows = m_display.width();
+			break;
+		default:
+			row = y;
+			rows = h;
+			panelRows = m_display.height();
+			break;
+	}
+	uint16_t rowBytes = (((uint32_t)m_display.width() * m_display.height()) / 8) / panelRows;
+
+	m_overlay = new uint8_t[rows * rowBytes];
+	if (NULL == m_overlay)
+	{
+		return false;
+	}
+	m_overlayOffset = row * rowBytes;
+	m_overlayBytes = rows * rowBytes;
+	memcpy(m_overlay, displayBuffer() + m_overlayOffset, m_overlayBytes);
+#else
+	// Save the rectangle a pixel at a time
+	m_overlay = new uint8_t[(((uint32_t)w * h) + 7) / 8];
+	if (NULL == m_overlay)
+	{
+		return false;
+	}
+	m_overlayX = x;
+	m_overlayY = y;
+	m_overlayW = w;
+	m_overlayH = h;
+	copyOverlay(true);
+#endif
+
+	m_overlayRows = true;
+
+	m_display.fillRect(x, y, w, h, m_inverted ? BLACK : WHITE);
+	return true;
+}
+
+// Put back what was under the popup
+void WatchMenu::closeOverlay(void)
+{
+	if (NULL == m_overlay)
+	{
+		return;
+	}
+#if WATCH_MENU_SHARPMEM_BUFFER
+	memcpy(displayBuffer() + m_overlayOffset, m_overlay, m_overlayBytes);
+#else
+	copyOverlay(false);
+#endif
+	delete[] m_overlay;
+	m_overlay = NULL;
+	m_overlayClosed = true;
+}
+
+// Send the framebuffer rows under the popup to the panel
+bool WatchMenu::refreshOverlay(uint8_t ss)
+{
+#if WATCH_MENU_SHARPMEM_BUFFER
+	if (!m_overlayRows || NULL == displayBuffer())
+	{
+		return false;
+	}
+
+	uint16_t rowBytes = (((uint32_t)m_display.width() * m_display.height()) / 8) /
+		((m_display.getRotation() & 1) ? m_display.width() : m_display.height());
+	sharpWriteLines(ss, m_vcom, m_overlayOffset / rowBytes, m_overlayBytes / rowBytes,
+		displayBuffer() + m_overlayOffset, rowBytes);
+	m_vcom = m_vcom ? 0x00 : SHARPMEM_BIT_VCOM;
+
+	// The rows put back by closeOverlay only need sending once
+	if (NULL == m_overlay)
+	{
+		m_overlayRows = false;
+	}
+	return true;
+#else
+	// Without the framebuffer there are no rows to send
+	return false;
+#endif
+}
+
+#if !WATCH_MENU_SHARPMEM_BUFFER
+// Save the popup rectangle's pixels to m_overlay, or put them back
+void WatchMenu::copyOverlay(bool save)
+{
+	uint32_t bit = 0;
+
+	for (int16_t y = m_overlayY; y < m_overlayY + m_overlayH; y++)
+	{
+		for (int16_t x = m_overlayX; x < m_overlayX + m_overlayW; x++, bit++)
+		{
+			uint8_t mask = 1 << (bit & 7);
+			if (save)
+			{
+				if (m_display.getPixel(x, y))
+				{
+					m_overlay[bit / 8] |= mask;
+				}
+				else
+				{
+					m_overlay[bit / 8] &= ~mask;
+				}
+			}
+			else
+			{
+				m_display.drawPixel(x, y, (m_overlay[bit / 8] & mask) ? WHITE : BLACK);
+			}
+		}
+	}
+}
+#endif
+
+// True if the next updateMenu draws over the display as it is: a popup
+// is open, or closeOverlay has just put back the menu and nothing about
+// it has changed since it was last drawn
+bool WatchMenu::menuKept(void)
+{
+	if (NULL != m_overlay)
+	{
+		return true;
+	}
+	return m_overlayClosed && m_overlayKeep &&
+		m_keptMenu == menu_selected &&
+		m_keptOption == menus[menu_selected]->option_selected &&
+		m_keptAnimX == menus[menu_selected]->animX &&
+		m_keptInverted == m_inverted &&
+		menuSettled();
+}
+#endif
+
+#if WATCH_MENU_ACTIONS
+bool WatchMenu::actionRunning(void)
+{
+#if WATCH_MENU_COROUTINES
+	if (m_task.valid())
+	{
+		return true;
+	}
+#endif
+	return m_stepFunc != NULL;
+}
+
+// Step the running action until it finishes or the time budget is used.
+// Returns true if the action is still running.
+bool WatchMenu::runAction(void)
+{
+	unsigned long start = millis();
+
+	// ACTION_DONE is only reported for the update the action finished in
+	m_actionFinished = false;
+
+	while (actionRunning())
+	{
+#if WATCH_MENU_COROUTINES
+		if (m_task.valid())
+		{
+			m_actionProgress = m_task.resume();
+			if (m_actionProgress >= ACTION_DONE)
+			{
+				m_task = WatchMenuTask();
+				m_actionFinished = true;
+			}
+		}
+		else
+#endif
+		{
+			m_actionProgress = m_stepFunc();
+			if (m_actionProgress >= ACTION_DONE)
+			{
+				m_stepFunc = NULL;
+				m_actionFinished = true;
+			}
+		}
+
+		if (millis() - start >= m_actionBudget)
+		{
+			break;
+		}
+	}
+	return actionRunning();
+}
+#endif
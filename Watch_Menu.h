@@ -25,6 +25,72 @@ All text above, and the splash screen must be included in any redistribution
   typedef uint8_t PortMask;
 #endif
 
+// Features that can be left out of the build to save flash and RAM.
+// Override any of these with 0 in the compiler flags, e.g.
+// -DWATCH_MENU_ICON=0 for a sketch that only uses string menus.
+// extras/size_report.sh shows the cost of each combination.
+//
+// The flags change the layout of WatchMenu, s_menu and s_option, so the
+// sketch and Watch_Menu.cpp must see the same values.  Set them in the
+// build flags for the whole build (compiler.cpp.extra_flags in
+// arduino-cli, build_flags in PlatformIO), never with a #define in the
+// sketch before including this header: the library is compiled on its
+// own without it and the two halves would disagree, with no error.
+#ifndef WATCH_MENU_STR
+ #define WATCH_MENU_STR		1	// MENU_TYPE_STR menus
+#endif
+#ifndef WATCH_MENU_ICON
+ #define WATCH_MENU_ICON		1	// MENU_TYPE_ICON carousel menus
+#endif
+#ifndef WATCH_MENU_ANIMATE
+ #define WATCH_MENU_ANIMATE	1	// Slide the carousel, otherwise jump to the option
+#endif
+#ifndef WATCH_MENU_INVERT
+ #define WATCH_MENU_INVERT	1	// Inverted spans in string menu options
+#endif
+#ifndef WATCH_MENU_FONTS
+ #define WATCH_MENU_FONTS	1	// setFont with custom GFX fonts
+#endif
+#ifndef WATCH_MENU_FRAME_CACHE
+ #define WATCH_MENU_FRAME_CACHE	1	// initFrameCache
+#endif
+#ifndef WATCH_MENU_OVERLAY
+ #define WATCH_MENU_OVERLAY	1	// openOverlay/closeOverlay popups
+#endif
+#ifndef WATCH_MENU_BANDS
+ #define WATCH_MENU_BANDS	1	// Band-by-band drawing to a SharpStrip
+#endif
+#ifndef WATCH_MENU_STRTAB
+ #define WATCH_MENU_STRTAB	1	// Compressed string tables from extras/strtab
+#endif
+#ifndef WATCH_MENU_ACTIONS
+ #define WATCH_MENU_ACTIONS	1	// Resumable option actions stepped by updateMenu
+#endif
+#ifndef WATCH_MENU_SHARPMEM_BUFFER
+ #define WATCH_MENU_SHARPMEM_BUFFER	1	// Copy the driver's framebuffer, see below
+#endif
+#ifndef WATCH_MENU_COROUTINES
+ #if WATCH_MENU_ACTIONS && defined(__cpp_impl_coroutine) && defined(__has_include)
+  #if __has_include(<coroutine>)
+   #define WATCH_MENU_COROUTINES	1	// C++20 coroutine actions, hosts only
+  #endif
+ #endif
+#endif
+#ifndef WATCH_MENU_COROUTINES
+ #define WATCH_MENU_COROUTINES	0
+#endif
+
+#if !WATCH_MENU_STR && !WATCH_MENU_ICON
+ #error "WatchMenu needs at least one of WATCH_MENU_STR or WATCH_MENU_ICON"
+#endif
+
+// The frame cache and popups copy Adafruit_SharpMem's private framebuffer,
+// sharpmem_buffer, with memcpy.  The member is there from Adafruit SHARP
+// Memory Display 1.1.0, which library.properties depends on.  With any
+// other driver build with WATCH_MENU_SHARPMEM_BUFFER=0: popups are then
+// saved with getPixel and put back with drawPixel, and initFrameCache
+// keeps no frames.
+
 #define MENU_TYPE_STR	0
 #define MENU_TYPE_ICON	1
 
@@ -62,21 +128,142 @@ typedef struct
 
 typedef void (*pFunc)(void);
 
+#if WATCH_MENU_STRTAB
+// Compressed string table, generated by extras/strtab.  All arrays are in
+// PROGMEM.  Each string is 0 terminated; bytes below 0x80 are characters,
+// bytes from 0x80 to 0xFE are dictionary words (byte & 0x7F), with a
+// space implied between two words in a row, and STRTAB_ESCAPE is
+// followed by a character from 0x80 up.  Words past dict_size and ids
+// past num_strings are drawn as nothing.
+typedef struct
+{
+	const uint8_t *dict;		// Dictionary words, each 0 terminated
+	const uint16_t *dict_index;	// Offset of each word in dict
+	const uint8_t *strings;		// Encoded strings
+	const uint16_t *string_index;	// Offset of each string in strings
+	uint8_t dict_size;		// Number of dictionary words
+	uint16_t num_strings;		// Number of strings
+}s_strtab;
+
+#define STRTAB_ESCAPE	0xFF	// Next byte is a character, not a word
+#define STR_NONE	0xFFFF	// The name is a plain PROGMEM string
+#endif
+
+// A menu or option name being decoded a character at a time
+typedef struct
+{
+	const uint8_t *str;	// PROGMEM name, or encoded table string
+	const uint8_t *word;	// Dictionary word being expanded
+#if WATCH_MENU_STRTAB
+	bool table;		// str is from the string table
+#endif
+}s_name;
+
+#if WATCH_MENU_BANDS
+class SharpStrip;
+#endif
+
+#if WATCH_MENU_ACTIONS
+#define ACTION_DONE	100
+
+// Resumable option action.  Called from updateMenu until it returns
+// ACTION_DONE, so each call should only do a short slice of the work.
+// Any other return value is the progress so far in percent.
+typedef int8_t (*pStepFunc)(void);
+#endif
+
+#if WATCH_MENU_COROUTINES
+#include <coroutine>
+
+// Coroutine option action, for hosts with C++20.  co_yield the progress
+// in percent after each slice of work and co_return when finished.
+class WatchMenuTask
+{
+public:
+	struct promise_type
+	{
+		int8_t progress;
+
+		WatchMenuTask get_return_object()
+		{
+			return WatchMenuTask(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		std::suspend_always yield_value(int8_t value) { progress = value; return {}; }
+		void return_void() { progress = ACTION_DONE; }
+		void unhandled_exception() { progress = ACTION_DONE; }
+	};
+
+	WatchMenuTask() : m_handle(nullptr) {}
+	WatchMenuTask(WatchMenuTask &&other) : m_handle(other.m_handle) { other.m_handle = nullptr; }
+	WatchMenuTask &operator=(WatchMenuTask &&other)
+	{
+		if (this != &other)
+		{
+			if (m_handle)
+			{
+				m_handle.destroy();
+			}
+			m_handle = other.m_handle;
+			other.m_handle = nullptr;
+		}
+		return *this;
+	}
+	~WatchMenuTask()
+	{
+		if (m_handle)
+		{
+			m_handle.destroy();
+		}
+	}
+
+	bool valid() { return m_handle && !m_handle.done(); };
+
+	// Run the next slice, returns the progress
+	int8_t resume()
+	{
+		m_handle.resume();
+		return m_handle.done() ? ACTION_DONE : m_handle.promise().progress;
+	}
+
+private:
+	explicit WatchMenuTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+	std::coroutine_handle<promise_type> m_handle;
+};
+
+typedef WatchMenuTask (*pTaskFunc)(void);
+#endif
+
 typedef struct
 {
 	int8_t num_items;
-	char name[20];
+	const char *name; // PROGMEM, not copied
+#if WATCH_MENU_STRTAB
+	uint16_t name_id; // String table id, used instead of name unless STR_NONE
+#endif
 	const uint8_t *icon;
 	int8_t menu_index;
+#if WATCH_MENU_INVERT
 	int8_t invert_start;
 	int8_t invert_length;
+#endif
 	pFunc func;
+#if WATCH_MENU_ACTIONS
+	pStepFunc stepFunc;
+#endif
+#if WATCH_MENU_COROUTINES
+	pTaskFunc taskFunc;
+#endif
 }s_option;
 
 typedef struct
 {
 	int8_t num_options;
-	char name[20];
+	const char *name; // PROGMEM, not copied
+#if WATCH_MENU_STRTAB
+	uint16_t name_id; // String table id, used instead of name unless STR_NONE
+#endif
 	s_option **options; // Array of pointer to options
 	int8_t option_selected;
 	int8_t prev_menu;
@@ -87,18 +274,48 @@ typedef struct
 	pFunc drawFunc;
 }s_menu;
 
+typedef struct
+{
+	bool valid;
+	uint8_t menu_index;
+	int8_t option_selected;
+	const GFXfont *font;
+	uint8_t textSize;
+	bool inverted;
+	uint8_t age;  // 0 = most recently used
+	uint8_t *buffer; // 1bpp copy of the whole display
+}s_frame;
+
 class WatchMenu
 {
 public:
 	WatchMenu(Adafruit_SharpMem& display);
+#if WATCH_MENU_BANDS
+	// Draw in bands of rows; updateMenu sends each band to the display.
+	// display.clearDisplay() does nothing here, each band starts filled;
+	// use display.clearPanel() to blank the panel itself.
+	WatchMenu(SharpStrip& display);
+#endif
 	void initMenu(uint8_t num);
+	// Only the name pointer is kept, not a copy, so a name must outlive
+	// the menu: a PSTR() or a static/global string.  A name built in a
+	// stack buffer (fine to pass on SAMD and ESP before, as names were
+	// copied) dangles once the function returns.
 	void createMenu(int8_t index, int8_t num_options, const char *name, int8_t menu_type = MENU_TYPE_ICON);
 	void createMenu(int8_t index, int8_t num_options, const char *name, int8_t menu_type, pFunc downFunc, pFunc upFunc);
 	void createOption(int8_t menu_index, int8_t opt_index, const char *name, const uint8_t *icon, pFunc actionFunc);
 	void createOption(int8_t menu_index, int8_t opt_index, const char *name, const uint8_t *icon, uint8_t prev_menu_index);
 	void createOption(int8_t menu_index, int8_t opt_index, pFunc actionFunc, uint8_t prev_menu_index);
 	void createOption(int8_t menu_index, int8_t opt_index, const char *name, uint8_t prev_menu_index);
+#if WATCH_MENU_ACTIONS
+	void createOption(int8_t menu_index, int8_t opt_index, const char *name, const uint8_t *icon, pStepFunc stepFunc);
+#endif
+#if WATCH_MENU_COROUTINES
+	void createOption(int8_t menu_index, int8_t opt_index, const char *name, const uint8_t *icon, pTaskFunc taskFunc);
+#endif
+#if WATCH_MENU_INVERT
 	void createOption(int8_t menu_index, int8_t opt_index, int16_t invert_start, int16_t invert_length, const char *name, const uint8_t *icon, pFunc actionFunc);
+#endif
 
 	bool updateMenu();
 	void upOption(void);
@@ -107,25 +324,119 @@ public:
 	bool menuUp(void);
 	bool selectOption(void);
 	void resetMenu(void);
+#if WATCH_MENU_ICON
 	bool menu_drawIcon();
+#endif
 	void setTextSize(uint8_t size);
 	void drawString(char* str, byte x, byte y);
 	void drawCentreString(char *str, int dX, int poY, int size);
 	void setDownFunc(pFunc func);
 	void setUpFunc(pFunc func);
+	// Drawn after the menu on every update.  When drawing to a SharpStrip
+	// it is called once per band, with only that band's rows kept: use
+	// inBand() to skip drawing that misses the band, and only do work
+	// that must happen once per update when bandTop() is 0.
 	void setDrawFunc(pFunc func);
+	bool inBand(int16_t y, int16_t h);
+	int16_t bandTop(void);
+#if WATCH_MENU_FONTS
 	void setFont(const GFXfont *font);
 	GFXfont *getFont(void);
+#endif
 	void selectedOption(int8_t menu_index, int8_t option_index);
+	int8_t getNumMenus(){ return num_menus; };
+	uint8_t getMenuSelected(){ return menu_selected; };
+	s_menu *getMenu(int8_t menu_index){ return menus[menu_index]; };
 	uint8_t fontWidth(){ return m_fontWidth; };
 	uint8_t fontHeight(){ return m_fontHeight; };
 	void invertDisplay(bool state);
+#if WATCH_MENU_STRTAB
+	// Name a menu or option by its STR_ id instead.  Names are looked up
+	// in the current table each time they are drawn, so switching tables
+	// switches the language of every menu.
+	void setStringTable(const s_strtab *table);
+	void setMenuName(int8_t menu_index, uint16_t id);
+	void setOptionName(int8_t menu_index, int8_t opt_index, uint16_t id);
+#endif
+#if WATCH_MENU_FRAME_CACHE
+	// Settled screens are copied whole from the framebuffer straight
+	// after the menu is drawn, and copied back in place of the next
+	// render.  Only the menu and the drawFunc should draw to the display:
+	// anything drawn before updateMenu, such as a clock, is cached with
+	// the menu and comes back stale.  Draw it from the drawFunc, which is
+	// not cached and runs after the copy.
+	void initFrameCache(uint8_t num_frames, uint16_t max_bytes);
+	void invalidateFrameCache(void);
+	void invalidateFrameCache(int8_t menu_index);
+#else
+	void initFrameCache(uint8_t num_frames, uint16_t max_bytes){};
+	void invalidateFrameCache(void){};
+	void invalidateFrameCache(int8_t menu_index){};
+#endif
+#if WATCH_MENU_OVERLAY
+	// Save the display rows under a popup so closing it is a copy, not a
+	// re-render.  While an overlay is open updateMenu leaves the menu
+	// alone and only calls the drawFunc, which draws the popup.  The first
+	// updateMenu after closeOverlay doesn't redraw the menu either if it
+	// is as it was when last drawn: same menu, option, animation
+	// and inversion, and no menu, option, name, font, text size or string
+	// table set since.  menuKept() is true for both, when the display must
+	// not be cleared before updateMenu.
+	bool openOverlay(int16_t x, int16_t y, int16_t w, int16_t h);
+	void closeOverlay(void);
+	bool overlayOpen(){ return m_overlay != NULL; };
+	bool menuKept(void);
+	// display.refresh() sends every row of the panel.  Call this instead
+	// to send only the popup's rows, while it is open and once more after
+	// closeOverlay when updateMenu kept the menu.  The rows are line
+	// writes on the hardware SPI pins with chip select ss, as SharpStrip
+	// sends its bands.  Returns false, sending nothing, when the whole
+	// display needs a refresh(): after a full render, or built with
+	// WATCH_MENU_SHARPMEM_BUFFER=0.  Anything the drawFunc draws outside
+	// the popup's rows waits for the next refresh().
+	bool refreshOverlay(uint8_t ss);
+#endif
+#if WATCH_MENU_ACTIONS
+	void setActionBudget(uint8_t ms){ m_actionBudget = ms; };
+	bool runAction(void);
+	bool actionRunning(void);
+	// Percent done, ACTION_DONE during the update the action finished in
+	// so the drawFunc can show it completing, otherwise -1
+	int8_t actionProgress(){ return actionRunning() || m_actionFinished ? m_actionProgress : -1; };
+#endif
 
 
   private:
 	void ultraFastDrawBitmap(s_image* image);
+	bool animateMenu();
+	void renderMenu();
+	bool textInBand(int16_t y);
+	void menuChanged(void);
+	s_name nameOf(s_menu *menu);
+	s_name nameOf(s_option *option);
+	char nameChar(s_name *name);
+	uint8_t nameLength(s_name name);
+	void nameBounds(s_name name, uint16_t *w, uint16_t *h);
+	void drawName(s_name name, int16_t x, int16_t y, int16_t invStart = -1, int16_t invLen = 0);
+	void drawCentreName(s_name name, int dX, int poY);
+#if WATCH_MENU_ICON
+	bool menu_animateIcon();
+	void menu_renderIcon();
+#endif
+#if WATCH_MENU_STR
 	void menu_drawStr();
-
+#endif
+#if WATCH_MENU_FRAME_CACHE || WATCH_MENU_OVERLAY
+	bool menuSettled();
+	uint8_t *displayBuffer();
+#endif
+#if WATCH_MENU_OVERLAY && !WATCH_MENU_SHARPMEM_BUFFER
+	void copyOverlay(bool save);
+#endif
+#if WATCH_MENU_FRAME_CACHE
+	s_frame *findFrame();
+	void storeFrame();
+#endif
 
 	int8_t num_menus;
 	s_menu **menus; //Array of pointers to menus
@@ -136,6 +447,46 @@ public:
 	uint8_t m_fontWidth;
 	uint8_t m_fontHeight;
 	bool m_inverted;
+#if WATCH_MENU_STRTAB
+	const s_strtab *m_strtab;
+#endif
+#if WATCH_MENU_BANDS
+	SharpStrip *m_strip; // Set when drawing band by band
+#endif
+#if WATCH_MENU_FRAME_CACHE
+	s_frame *m_frames; // Cache of fully rendered static screens
+	uint8_t m_numFrames;
+	uint16_t m_frameBytes;
+#endif
+#if WATCH_MENU_OVERLAY
+	uint8_t *m_overlay; // Framebuffer rows under the open popup
+#if WATCH_MENU_SHARPMEM_BUFFER
+	uint16_t m_overlayOffset;
+	uint16_t m_overlayBytes;
+#else
+	int16_t m_overlayX;
+	int16_t m_overlayY;
+	int16_t m_overlayW;
+	int16_t m_overlayH;
+#endif
+	bool m_overlayKeep; // The menu as updateMenu last drew it
+	bool m_overlayClosed; // closeOverlay has put it back
+	uint8_t m_keptMenu;
+	int8_t m_keptOption;
+	int16_t m_keptAnimX;
+	bool m_keptInverted;
+	bool m_overlayRows; // The popup's rows are all refreshOverlay has to send
+	uint8_t m_vcom; // VCOM bit of the next line write
+#endif
+#if WATCH_MENU_ACTIONS
+	pStepFunc m_stepFunc; // Action being stepped by updateMenu
+	int8_t m_actionProgress;
+	uint8_t m_actionBudget; // Milliseconds of action work per update
+	bool m_actionFinished;
+#endif
+#if WATCH_MENU_COROUTINES
+	WatchMenuTask m_task;
+#endif
 };
 
 
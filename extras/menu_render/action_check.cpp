@@ -0,0 +1,200 @@
+/*********************************************************************
+Host check for WatchMenu option actions.
+
+Runs a resumable action and, with C++20, a coroutine action through
+updateMenu against a simulated millis().  Checks that each update does
+one time budget of slices, that only one action runs at a time, that
+actionProgress() reports ACTION_DONE for exactly the update the action
+finished in and that a finished coroutine is destroyed.  Exits with 1
+if any check fails.
+
+Build on Linux against a checkout of the Adafruit GFX Library:
+
+  g++ -std=c++20 -Iextras/menu_render/host -I. -I$GFX \
+    extras/menu_render/action_check.cpp \
+    Watch_Menu.cpp Sharp_Strip.cpp icons.cpp $GFX/Adafruit_GFX.cpp -o action_check
+
+With -std=c++11 the coroutine checks are left out.
+*********************************************************************/
+#include <stdio.h>
+
+#include <SPI.h>
+#include "Adafruit_SharpMem.h"
+#include "Watch_Menu.h"
+
+#if !WATCH_MENU_ACTIONS
+ #error "action_check needs WATCH_MENU_ACTIONS"
+#endif
+
+#define SLICES		10	// Slices of work in each action
+#define SLICE_MS	3	// Simulated time each slice takes
+#define BUDGET_MS	10	// So 4 slices fit in an update
+
+SPIClass SPI;
+
+static unsigned long simMillis = 0;
+
+unsigned long millis(void)
+{
+	return simMillis;
+}
+
+unsigned long micros(void)
+{
+	return simMillis * 1000;
+}
+
+void delay(unsigned long ms)
+{
+	simMillis += ms;
+}
+
+static int failures = 0;
+
+#define CHECK(cond) \
+	do \
+	{ \
+		if (!(cond)) \
+		{ \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static Adafruit_SharpMem display(0, 0, 0, 144, 168);
+static WatchMenu menu(display);
+
+static uint8_t slices = 0;
+static int8_t drawnProgress = -1;
+
+static void noAction(void)
+{
+}
+
+// What a progress bar drawFunc would see
+static void drawProgress(void)
+{
+	drawnProgress = menu.actionProgress();
+}
+
+static int8_t stepSync(void)
+{
+	simMillis += SLICE_MS;
+	slices++;
+	return (slices >= SLICES) ? ACTION_DONE : (slices * 100) / SLICES;
+}
+
+#if WATCH_MENU_COROUTINES
+static uint8_t framesAlive = 0;
+
+// Lives in the coroutine frame, so shows when the frame is destroyed
+struct FrameTracker
+{
+	FrameTracker() { framesAlive++; }
+	~FrameTracker() { framesAlive--; }
+};
+
+static WatchMenuTask scan(void)
+{
+	FrameTracker tracker;
+
+	while (true)
+	{
+		simMillis += SLICE_MS;
+		slices++;
+		if (slices >= SLICES)
+		{
+			break;
+		}
+		co_yield (int8_t)((slices * 100) / SLICES);
+	}
+}
+#endif
+
+// Start the selected option's action and update until it has finished,
+// checking every update against the budget
+static void checkAction(const char *name, uint8_t budget)
+{
+	uint8_t perUpdate = (budget == 0) ? 1 : (budget + SLICE_MS - 1) / SLICE_MS;
+	uint8_t updates = 0;
+
+	printf("%s, %dms budget\n", name, budget);
+	menu.setActionBudget(budget);
+	slices = 0;
+
+	CHECK(menu.actionProgress() == -1);
+	CHECK(menu.selectOption());
+	CHECK(menu.actionRunning());
+	CHECK(menu.actionProgress() == 0);
+
+	// Only one action runs at a time
+	CHECK(!menu.selectOption());
+
+	while (menu.actionRunning() && updates < 100)
+	{
+		uint8_t before = slices;
+		uint8_t expected = (SLICES - before < perUpdate) ? SLICES - before : perUpdate;
+
+		CHECK(menu.updateMenu());
+		updates++;
+		CHECK(slices - before == expected);
+		if (slices < SLICES)
+		{
+			CHECK(menu.actionRunning());
+			CHECK(drawnProgress == (slices * 100) / SLICES);
+		}
+	}
+	CHECK(updates == (SLICES + perUpdate - 1) / perUpdate);
+
+	// The update that finished the action showed ACTION_DONE and asked
+	// for one more update to clear it
+	CHECK(slices == SLICES);
+	CHECK(!menu.actionRunning());
+	CHECK(drawnProgress == ACTION_DONE);
+	CHECK(menu.actionProgress() == ACTION_DONE);
+
+	CHECK(!menu.updateMenu());
+	CHECK(drawnProgress == -1);
+	CHECK(menu.actionProgress() == -1);
+	CHECK(!menu.updateMenu());
+}
+
+int main(void)
+{
+	menu.initMenu(1);
+	menu.setTextSize(1);
+	menu.createMenu(0, 4, PSTR("ACTIONS"), MENU_TYPE_STR);
+	menu.createOption(0, 0, PSTR("SYNC"), NULL, stepSync);
+#if WATCH_MENU_COROUTINES
+	menu.createOption(0, 1, PSTR("SCAN"), NULL, scan);
+#else
+	menu.createOption(0, 1, PSTR("SCAN"), NULL, noAction);
+#endif
+	menu.createOption(0, 2, PSTR("NOTHING"), NULL, noAction);
+	menu.createOption(0, 3, PSTR("EXIT"), (uint8_t)0);
+	menu.setDrawFunc(drawProgress);
+
+	// Nothing running, so the menu settles straight away
+	CHECK(!menu.updateMenu());
+	CHECK(drawnProgress == -1);
+
+	checkAction("step action", BUDGET_MS);
+	checkAction("step action", 0);
+
+#if WATCH_MENU_COROUTINES
+	menu.downOption();
+	checkAction("coroutine action", BUDGET_MS);
+	CHECK(framesAlive == 0);
+	checkAction("coroutine action", 0);
+	CHECK(framesAlive == 0);
+#endif
+
+	// An option with a plain function runs it straight away
+	menu.selectedOption(0, 2);
+	CHECK(menu.selectOption());
+	CHECK(!menu.actionRunning());
+	CHECK(menu.actionProgress() == -1);
+
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
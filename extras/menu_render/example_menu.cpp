@@ -0,0 +1,49 @@
+/*********************************************************************
+Example menu definition for menu_render.
+*********************************************************************/
+#include "menu_render.h"
+#include <Fonts/FreeMono9pt7b.h>
+
+extern const uint8_t menu_default[];
+
+static void noAction(void)
+{
+}
+
+static void drawStatus(void)
+{
+	renderDisplay->setCursor(0, 10);
+	renderDisplay->print("12:00");
+}
+
+void defineMenu(WatchMenu &menu)
+{
+	menu.initMenu(3);
+	menu.setTextSize(1);
+#if WATCH_MENU_FONTS
+	// A custom font, so the renderer covers the font glyph lookups
+	menu.setFont(&FreeMono9pt7b);
+#endif
+
+	menu.createMenu(0, 4, PSTR("MAIN"), MENU_TYPE_ICON);
+	menu.createOption(0, 0, PSTR("ALARMS"), menu_default, noAction);
+	menu.createOption(0, 1, PSTR("SETTINGS"), menu_default, (uint8_t)1);
+	menu.createOption(0, 2, PSTR("DISPLAY"), menu_default, (uint8_t)2);
+	menu.createOption(0, 3, PSTR("EXIT"), menu_default, (uint8_t)0);
+	menu.setDrawFunc(drawStatus);
+
+	menu.createMenu(1, 4, PSTR("SETTINGS"), MENU_TYPE_STR);
+#if WATCH_MENU_INVERT
+	menu.createOption(1, 0, 4, 2, PSTR("TIME 12:00"), NULL, noAction);
+#else
+	menu.createOption(1, 0, PSTR("TIME 12:00"), NULL, noAction);
+#endif
+	menu.createOption(1, 1, PSTR("DATE"), NULL, noAction);
+	menu.createOption(1, 2, PSTR("SYNC"), NULL, noAction);
+	menu.createOption(1, 3, PSTR("EXIT"), (uint8_t)0);
+
+	menu.createMenu(2, 3, PSTR("DISPLAY"), MENU_TYPE_ICON);
+	menu.createOption(2, 0, PSTR("INVERT"), menu_default, noAction);
+	menu.createOption(2, 1, PSTR("FONT"), menu_default, noAction);
+	menu.createOption(2, 2, PSTR("EXIT"), menu_default, (uint8_t)0);
+}
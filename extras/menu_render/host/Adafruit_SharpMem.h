@@ -0,0 +1,85 @@
+/*********************************************************************
+Headless stand in for Adafruit_SharpMem on a Linux host.
+
+Keeps the same 1bpp framebuffer layout as the real driver and counts
+pixel writes and top level draw calls so the renderer can report the
+cost of each frame.  refresh() does nothing.
+*********************************************************************/
+#ifndef _HOST_ADAFRUIT_SHARPMEM_H
+#define _HOST_ADAFRUIT_SHARPMEM_H
+
+#include <Adafruit_GFX.h>
+
+#define SHARPMEM_BLACK 0
+#define SHARPMEM_WHITE 1
+
+class Adafruit_SharpMem : public Adafruit_GFX
+{
+public:
+	Adafruit_SharpMem(uint8_t clk, uint8_t mosi, uint8_t ss, uint16_t w = 96, uint16_t h = 96)
+		: Adafruit_GFX(w, h), pixelWrites(0), drawCalls(0), m_depth(0)
+	{
+		sharpmem_buffer = new uint8_t[(w * h) / 8];
+		clearDisplayBuffer();
+	}
+	~Adafruit_SharpMem() { delete[] sharpmem_buffer; }
+
+	boolean begin() { return true; }
+	void refresh(void) {}
+	void clearDisplay() { clearDisplayBuffer(); }
+	void clearDisplayBuffer()
+	{
+		memset(sharpmem_buffer, 0xFF, (WIDTH * HEIGHT) / 8);
+	}
+
+	void drawPixel(int16_t x, int16_t y, uint16_t color)
+	{
+		if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height))
+		{
+			return;
+		}
+		pixelWrites++;
+		uint32_t bit = (y * WIDTH) + x;
+		if (color)
+		{
+			sharpmem_buffer[bit / 8] |= (1 << (bit & 7));
+		}
+		else
+		{
+			sharpmem_buffer[bit / 8] &= ~(1 << (bit & 7));
+		}
+	}
+
+	uint8_t getPixel(uint16_t x, uint16_t y)
+	{
+		if ((x >= _width) || (y >= _height))
+		{
+			return 0;
+		}
+		uint32_t bit = (y * WIDTH) + x;
+		return sharpmem_buffer[bit / 8] & (1 << (bit & 7)) ? 1 : 0;
+	}
+
+	// Every GFX primitive is wrapped in startWrite/endWrite, so count
+	// the outermost pair as one draw call.
+	void startWrite(void)
+	{
+		if (m_depth++ == 0)
+		{
+			drawCalls++;
+		}
+	}
+	void endWrite(void)
+	{
+		m_depth--;
+	}
+
+	uint32_t pixelWrites;
+	uint32_t drawCalls;
+
+private:
+	uint8_t *sharpmem_buffer; // Private, as in the real driver
+	uint8_t m_depth;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/*********************************************************************
+Minimal Arduino core for building WatchMenu and Adafruit GFX on a
+Linux host.  Only what the menu renderer needs is provided.
+*********************************************************************/
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#define ARDUINO 100
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#ifndef pgm_read_byte
+ #define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+#ifndef pgm_read_word
+ #define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#endif
+#ifndef pgm_read_dword
+ #define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#endif
+#ifndef pgm_read_pointer
+ #define pgm_read_pointer(addr) (*(void * const *)(addr))
+#endif
+#ifndef pgm_read_ptr
+ #define pgm_read_ptr(addr) (*(void * const *)(addr))
+#endif
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+class __FlashStringHelper;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+inline void yield(void) {}
+
+class String : public std::string
+{
+public:
+	String(const char *str = "") : std::string(str) {}
+};
+
+#include "Print.h"
+
+#endif
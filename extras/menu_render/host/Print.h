@@ -0,0 +1,45 @@
+/*********************************************************************
+Minimal Arduino Print class for the Linux host build.
+*********************************************************************/
+#ifndef _HOST_PRINT_H
+#define _HOST_PRINT_H
+
+#include <stdio.h>
+#include "Arduino.h"
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size)
+	{
+		size_t n = 0;
+		while (size--)
+		{
+			n += write(*buffer++);
+		}
+		return n;
+	}
+	size_t write(const char *str)
+	{
+		return str == NULL ? 0 : write((const uint8_t *)str, strlen(str));
+	}
+
+	size_t print(const __FlashStringHelper *str) { return write((const char *)str); }
+	size_t print(const String &str) { return write(str.c_str()); }
+	size_t print(const char str[]) { return write(str); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(long n)
+	{
+		char buf[24];
+		snprintf(buf, sizeof(buf), "%ld", n);
+		return write(buf);
+	}
+	size_t print(int n) { return print((long)n); }
+	size_t print(unsigned int n) { return print((long)n); }
+	size_t println(void) { return write("\r\n"); }
+	size_t println(const char str[]) { return print(str) + println(); }
+};
+
+#endif
@@ -0,0 +1,30 @@
+/*********************************************************************
+SPI stand in for the Linux host build, nothing is sent.
+*********************************************************************/
+#ifndef _HOST_SPI_H
+#define _HOST_SPI_H
+
+#include "Arduino.h"
+
+#define SCK 0
+#define MOSI 0
+#define SPI_MODE0 0
+
+class SPISettings
+{
+public:
+	SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {}
+};
+
+class SPIClass
+{
+public:
+	void begin(void) {}
+	void beginTransaction(SPISettings settings) {}
+	void endTransaction(void) {}
+	uint8_t transfer(uint8_t data) { return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif
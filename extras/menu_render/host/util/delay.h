@@ -0,0 +1 @@
+// Not needed on the Linux host
@@ -0,0 +1,440 @@
+/*********************************************************************
+Offline renderer for WatchMenu.
+
+Walks every menu state reachable through selectOption, upOption and
+downOption, including each step of the icon carousel animation, and
+renders it headlessly.  States are spread over all cores with a work
+stealing pool.  Writes one PBM image per state and costs.csv with the
+render time, pixel writes and draw calls of each, slowest first.
+
+Each state is rendered several times (-r) and the fastest run is kept.
+The frame cache is emptied before each run, so a definition that calls
+initFrameCache still reports the cost of rendering every state.
+Runs are timed with the thread's CPU clock, so time spent descheduled
+while other workers run does not count.
+
+Build on Linux against a checkout of the Adafruit GFX Library:
+
+  g++ -std=c++11 -O2 -pthread \
+    -Iextras/menu_render/host -Iextras/menu_render -I. -I$GFX \
+    extras/menu_render/menu_render.cpp extras/menu_render/example_menu.cpp \
+    Watch_Menu.cpp Sharp_Strip.cpp icons.cpp $GFX/Adafruit_GFX.cpp -o menu_render
+
+Replace example_menu.cpp with your own menu definition, see menu_render.h.
+
+Usage: menu_render [-o outdir] [-j threads] [-r runs] [-w width] [-h height]
+*********************************************************************/
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SPI.h>
+#include "menu_render.h"
+
+#define MAX_ANIM_STEPS	64	// Give up on an animation that never settles
+
+thread_local Adafruit_SharpMem *renderDisplay = NULL;
+SPIClass SPI;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long micros(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long millis(void)
+{
+	return micros() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// One unit of work: reach menu from the top by selecting each option in
+// path, settle on option from, then move by dir (0 = stay, 1 = down,
+// -1 = up) and render every frame until the carousel settles.
+typedef struct
+{
+	std::vector<int8_t> path;
+	uint8_t menu;
+	int8_t from;
+	int8_t dir;
+}s_work;
+
+typedef struct
+{
+	uint8_t menu;
+	int8_t option;
+	int8_t from;
+	int8_t dir;
+	uint8_t step;
+	uint32_t renderNanos; // Fastest of the runs
+	uint32_t pixelWrites;
+	uint32_t drawCalls;
+	std::string file;
+}s_result;
+
+class WorkQueue
+{
+public:
+	void push(const s_work &work)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_items.push_back(work);
+	}
+
+	// The owner takes from the back...
+	bool pop(s_work &work)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		if (m_items.empty())
+		{
+			return false;
+		}
+		work = m_items.back();
+		m_items.pop_back();
+		return true;
+	}
+
+	// ...and other workers steal from the front
+	bool steal(s_work &work)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		if (m_items.empty())
+		{
+			return false;
+		}
+		work = m_items.front();
+		m_items.pop_front();
+		return true;
+	}
+
+private:
+	std::mutex m_lock;
+	std::deque<s_work> m_items;
+};
+
+static std::string outDir = "menu_render_out";
+static uint16_t displayWidth = 144;
+static uint16_t displayHeight = 168;
+static unsigned runs = 20;
+
+// CPU time used by the calling thread
+static uint64_t threadNanos(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+
+static bool validMenu(WatchMenu &menu, int8_t index)
+{
+	return index >= 0 && index < menu.getNumMenus() && menu.getMenu(index) != NULL;
+}
+
+// Selecting an option without any action moves to its sub menu
+static bool subMenuOption(s_option *option)
+{
+#if WATCH_MENU_ACTIONS
+	if (NULL != option->stepFunc)
+	{
+		return false;
+	}
+#endif
+#if WATCH_MENU_COROUTINES
+	if (NULL != option->taskFunc)
+	{
+		return false;
+	}
+#endif
+	return NULL == option->func;
+}
+
+// Breadth first search of the menus reachable by selecting sub menu options
+static void enumerateWork(std::vector<s_work> &work)
+{
+	Adafruit_SharpMem display(0, 0, 0, displayWidth, displayHeight);
+	WatchMenu menu(display);
+	renderDisplay = &display;
+	defineMenu(menu);
+
+	std::vector<std::vector<int8_t> > paths(menu.getNumMenus());
+	std::vector<bool> visited(menu.getNumMenus(), false);
+	std::deque<int8_t> pending;
+
+	if (!validMenu(menu, 0))
+	{
+		return;
+	}
+	visited[0] = true;
+	pending.push_back(0);
+
+	while (!pending.empty())
+	{
+		int8_t index = pending.front();
+		pending.pop_front();
+		s_menu *m = menu.getMenu(index);
+
+		for (int8_t opt = 0; opt < m->num_options; opt++)
+		{
+			s_option *option = m->options[opt];
+			if (NULL == option)
+			{
+				continue;
+			}
+
+			s_work item = { paths[index], (uint8_t)index, opt, 0 };
+			work.push_back(item);
+			if (MENU_TYPE_ICON == m->type)
+			{
+				item.dir = 1;
+				work.push_back(item);
+				item.dir = -1;
+				work.push_back(item);
+			}
+
+			// The last option is the exit back to the previous menu
+			if (subMenuOption(option) && opt != m->num_options - 1 &&
+				validMenu(menu, option->menu_index) && !visited[option->menu_index])
+			{
+				visited[option->menu_index] = true;
+				paths[option->menu_index] = paths[index];
+				paths[option->menu_index].push_back(opt);
+				pending.push_back(option->menu_index);
+			}
+		}
+	}
+}
+
+static void writeFrame(Adafruit_SharpMem &display, const std::string &file)
+{
+	FILE *out = fopen(file.c_str(), "wb");
+	if (NULL == out)
+	{
+		return;
+	}
+
+	// Binary PBM, 1 is black
+	fprintf(out, "P4\n%d %d\n", display.width(), display.height());
+	std::vector<uint8_t> row((display.width() + 7) / 8);
+	for (int16_t y = 0; y < display.height(); y++)
+	{
+		std::fill(row.begin(), row.end(), 0);
+		for (int16_t x = 0; x < display.width(); x++)
+		{
+			if (!display.getPixel(x, y))
+			{
+				row[x >> 3] |= 0x80 >> (x & 7);
+			}
+		}
+		fwrite(&row[0], 1, row.size(), out);
+	}
+	fclose(out);
+}
+
+static void renderWork(WatchMenu &menu, Adafruit_SharpMem &display,
+	const s_work &work, std::vector<s_result> &results)
+{
+	// Navigate to the menu the same way a user would
+	menu.resetMenu();
+	for (size_t index = 0; index < work.path.size(); index++)
+	{
+		menu.selectedOption(menu.getMenuSelected(), work.path[index]);
+		menu.selectOption();
+	}
+	menu.selectedOption(work.menu, work.from);
+
+	// Settle the carousel on the starting option
+	for (uint8_t step = 0; step < MAX_ANIM_STEPS; step++)
+	{
+		display.clearDisplay();
+		if (!menu.updateMenu())
+		{
+			break;
+		}
+	}
+
+	if (work.dir > 0)
+	{
+		menu.downOption();
+	}
+	else if (work.dir < 0)
+	{
+		menu.upOption();
+	}
+
+	s_menu *m = menu.getMenu(work.menu);
+	int8_t option = m->option_selected;
+	for (uint8_t step = 0; step < MAX_ANIM_STEPS; step++)
+	{
+		// Put the carousel back before each repeat so every run draws
+		// the same frame, and drop any frame cached by the definition's
+		// initFrameCache so every run renders it rather than copying it
+		int16_t animX = m->animX;
+		uint64_t fastest = UINT64_MAX;
+		bool bAnimating = false;
+		for (unsigned run = 0; run < runs; run++)
+		{
+			m->animX = animX;
+			menu.invalidateFrameCache();
+			display.clearDisplay();
+			display.pixelWrites = 0;
+			display.drawCalls = 0;
+
+			uint64_t start = threadNanos();
+			bAnimating = menu.updateMenu();
+			uint64_t elapsed = threadNanos() - start;
+			fastest = std::min(fastest, elapsed);
+		}
+
+		char name[64];
+		snprintf(name, sizeof(name), "/m%d_o%d_f%d_d%d_s%d.pbm",
+			work.menu, option, work.from, work.dir, step);
+
+		s_result result;
+		result.menu = work.menu;
+		result.option = option;
+		result.from = work.from;
+		result.dir = work.dir;
+		result.step = step;
+		result.renderNanos = fastest;
+		result.pixelWrites = display.pixelWrites;
+		result.drawCalls = display.drawCalls;
+		result.file = outDir + name;
+		results.push_back(result);
+
+		writeFrame(display, result.file);
+
+		if (!bAnimating)
+		{
+			break;
+		}
+	}
+}
+
+static void worker(uint8_t id, std::vector<WorkQueue> &queues, std::vector<s_result> &results)
+{
+	Adafruit_SharpMem display(0, 0, 0, displayWidth, displayHeight);
+	WatchMenu menu(display);
+	renderDisplay = &display;
+	defineMenu(menu);
+
+	s_work work;
+	while (true)
+	{
+		bool found = queues[id].pop(work);
+		for (size_t other = 1; !found && other < queues.size(); other++)
+		{
+			found = queues[(id + other) % queues.size()].steal(work);
+		}
+		if (!found)
+		{
+			// Nothing new is ever queued, so every queue is now empty
+			return;
+		}
+		renderWork(menu, display, work, results);
+	}
+}
+
+static bool slower(const s_result &a, const s_result &b)
+{
+	return a.renderNanos > b.renderNanos;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned threads = std::thread::hardware_concurrency();
+	int opt;
+
+	while ((opt = getopt(argc, argv, "o:j:r:w:h:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'o': outDir = optarg; break;
+			case 'j': threads = atoi(optarg); break;
+			case 'r': runs = atoi(optarg); break;
+			case 'w': displayWidth = atoi(optarg); break;
+			case 'h': displayHeight = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-o outdir] [-j threads] [-r runs] [-w width] [-h height]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (threads == 0)
+	{
+		threads = 1;
+	}
+	if (runs == 0)
+	{
+		runs = 1;
+	}
+	mkdir(outDir.c_str(), 0755);
+
+	std::vector<s_work> work;
+	enumerateWork(work);
+
+	std::vector<WorkQueue> queues(threads);
+	for (size_t index = 0; index < work.size(); index++)
+	{
+		queues[index % threads].push(work[index]);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::vector<s_result> > results(threads);
+	std::vector<std::thread> pool;
+	for (unsigned index = 0; index < threads; index++)
+	{
+		pool.push_back(std::thread(worker, index, std::ref(queues), std::ref(results[index])));
+	}
+	for (unsigned index = 0; index < threads; index++)
+	{
+		pool[index].join();
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	std::vector<s_result> all;
+	for (unsigned index = 0; index < threads; index++)
+	{
+		all.insert(all.end(), results[index].begin(), results[index].end());
+	}
+	std::sort(all.begin(), all.end(), slower);
+
+	std::string csvName = outDir + "/costs.csv";
+	FILE *csv = fopen(csvName.c_str(), "w");
+	if (NULL == csv)
+	{
+		perror(csvName.c_str());
+		return 1;
+	}
+	fprintf(csv, "menu,option,from,dir,step,render_ns,pixel_writes,draw_calls,file\n");
+	for (size_t index = 0; index < all.size(); index++)
+	{
+		const s_result &r = all[index];
+		fprintf(csv, "%d,%d,%d,%d,%d,%u,%u,%u,%s\n", r.menu, r.option, r.from, r.dir,
+			r.step, r.renderNanos, r.pixelWrites, r.drawCalls, r.file.c_str());
+	}
+	fclose(csv);
+
+	printf("%u states rendered in %ld ms on %u threads\n", (unsigned)all.size(),
+		(long)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), threads);
+	printf("Slowest states:\n");
+	for (size_t index = 0; index < all.size() && index < 10; index++)
+	{
+		const s_result &r = all[index];
+		printf("  %8.2f us %7u px %4u calls  %s\n", r.renderNanos / 1000.0, r.pixelWrites, r.drawCalls, r.file.c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,20 @@
+/*********************************************************************
+Offline menu renderer for WatchMenu.
+
+A menu definition is a source file that provides defineMenu(), normally
+the same createMenu/createOption calls the sketch makes in setup().
+Each worker thread builds its own WatchMenu from it, so the definition
+must not keep state in globals.  drawFunc callbacks should draw to
+renderDisplay, which points at the calling worker's display.
+*********************************************************************/
+#ifndef _MENU_RENDER_H
+#define _MENU_RENDER_H
+
+#include "Adafruit_SharpMem.h"
+#include "Watch_Menu.h"
+
+void defineMenu(WatchMenu &menu);
+
+extern thread_local Adafruit_SharpMem *renderDisplay;
+
+#endif
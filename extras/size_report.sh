@@ -0,0 +1,153 @@
+#!/bin/sh
+#
+# Report the flash and RAM cost of each WatchMenu feature combination.
+#
+# Builds a small sketch that uses the library with arduino-cli, once per
+# combination of the WATCH_MENU_* flags in Watch_Menu.h, and prints the
+# program and global variable sizes.  Needs arduino-cli with the board core,
+# Adafruit GFX Library and Adafruit SHARP Memory Display installed.
+#
+#   extras/size_report.sh [fqbn [FLAG ...]]
+#
+# The default fqbn is arduino:avr:uno.  Every combination of the named
+# flags is built, e.g. "ICON FONTS" for four builds, with the other flags
+# left on.  With no flags all of them are varied, which is 512 builds once
+# the combinations that compile to the same code are skipped: no menu
+# type at all, ANIMATE without ICON and INVERT without STR.
+#
+
+FQBN=${1:-arduino:avr:uno}
+[ $# -gt 0 ] && shift
+ALL_FLAGS="STR ICON ANIMATE INVERT FONTS FRAME_CACHE OVERLAY ACTIONS BANDS STRTAB"
+VARY=${*:-$ALL_FLAGS}
+LIBDIR=$(cd "$(dirname "$0")/.." && pwd)
+WORKDIR=$(mktemp -d)
+SKETCH=$WORKDIR/SizeReport
+
+trap 'rm -rf "$WORKDIR"' EXIT
+
+mkdir -p "$SKETCH"
+cat > "$SKETCH/SizeReport.ino" <<'SKETCH_EOF'
+#include <Adafruit_GFX.h>
+#include <Adafruit_SharpMem.h>
+#include <Watch_Menu.h>
+
+Adafruit_SharpMem display(13, 11, 10, 144, 168);
+WatchMenu menu(display);
+
+void action() {}
+#if WATCH_MENU_ACTIONS
+int8_t stepAction() { return ACTION_DONE; }
+#endif
+
+void setup()
+{
+	display.begin();
+	menu.initMenu(2);
+#if WATCH_MENU_STR
+	menu.createMenu(0, 3, PSTR("MAIN"), MENU_TYPE_STR);
+#else
+	menu.createMenu(0, 3, PSTR("MAIN"), MENU_TYPE_ICON);
+#endif
+#if WATCH_MENU_INVERT
+	menu.createOption(0, 0, 0, 2, PSTR("SET TIME"), NULL, action);
+#else
+	menu.createOption(0, 0, PSTR("SET TIME"), NULL, action);
+#endif
+	menu.createOption(0, 1, PSTR("SUB"), NULL, 1);
+	menu.createOption(0, 2, PSTR("EXIT"), NULL, (uint8_t)0);
+#if WATCH_MENU_ICON
+	menu.createMenu(1, 2, PSTR("SUB"), MENU_TYPE_ICON);
+#else
+	menu.createMenu(1, 2, PSTR("SUB"), MENU_TYPE_STR);
+#endif
+#if WATCH_MENU_ACTIONS
+	menu.createOption(1, 0, PSTR("ACTION"), NULL, stepAction);
+#else
+	menu.createOption(1, 0, PSTR("ACTION"), NULL, action);
+#endif
+	menu.createOption(1, 1, PSTR("EXIT"), NULL, (uint8_t)0);
+	menu.initFrameCache(2, 2048);
+	menu.setTextSize(1);
+}
+
+void loop()
+{
+#if WATCH_MENU_OVERLAY
+	if (!menu.menuKept())
+#endif
+	{
+		display.clearDisplay();
+	}
+	menu.updateMenu();
+#if WATCH_MENU_OVERLAY
+	if (!menu.refreshOverlay(10))
+#endif
+	{
+		display.refresh();
+	}
+	menu.downOption();
+	menu.selectOption();
+#if WATCH_MENU_OVERLAY
+	if (menu.openOverlay(10, 40, 100, 30))
+	{
+		menu.updateMenu();
+		menu.refreshOverlay(10);
+		menu.closeOverlay();
+	}
+#endif
+}
+SKETCH_EOF
+
+report()
+{
+	NAME=$1
+	FLAGS=$2
+	OUT=$(arduino-cli compile --fqbn "$FQBN" --library "$LIBDIR" \
+		--build-property "compiler.cpp.extra_flags=$FLAGS" \
+		--build-property "compiler.c.extra_flags=$FLAGS" \
+		"$SKETCH" 2>&1)
+	if [ $? -ne 0 ]; then
+		printf '%8s %8s %s\n' "failed" "" "$NAME"
+		echo "$OUT" >&2
+		return
+	fi
+	FLASH=$(echo "$OUT" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+	RAM=$(echo "$OUT" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+	printf '%8s %8s %s\n' "$FLASH" "$RAM" "$NAME"
+}
+
+# Bit n of the combination turns off the nth flag in $VARY, so the first
+# build has every feature and the last has the fewest
+COUNT=$(echo $VARY | wc -w)
+COMBO=0
+
+printf '%8s %8s  %s\n' "flash" "ram" "disabled"
+while [ $COMBO -lt $((1 << COUNT)) ]; do
+	for FLAG in $ALL_FLAGS; do
+		eval "V_$FLAG=1"
+	done
+	BIT=0
+	FLAGS=""
+	NAME=""
+	for FLAG in $VARY; do
+		if [ $(((COMBO >> BIT) & 1)) -eq 1 ]; then
+			eval "V_$FLAG=0"
+			FLAGS="$FLAGS -DWATCH_MENU_$FLAG=0"
+			NAME="$NAME $FLAG"
+		fi
+		BIT=$((BIT + 1))
+	done
+	COMBO=$((COMBO + 1))
+
+	if [ $V_STR -eq 0 ] && [ $V_ICON -eq 0 ]; then
+		continue
+	fi
+	if [ $V_ICON -eq 0 ] && [ $V_ANIMATE -eq 0 ]; then
+		continue
+	fi
+	if [ $V_STR -eq 0 ] && [ $V_INVERT -eq 0 ]; then
+		continue
+	fi
+	report "${NAME:- (none)}" "$FLAGS"
+done
@@ -0,0 +1,325 @@
+/*********************************************************************
+String table compiler for WatchMenu.
+
+Reads menu and option names, one per line as "ID text", and writes a
+header with the names compressed against a dictionary of common words.
+Lines starting with # and blank lines are ignored.  Build one table per
+language, each listing the same IDs in the same order.
+
+Text is stored as bytes, so write the file in the font's 8 bit encoding
+rather than UTF-8.  The built in font is code page 437, where 0x81 is
+u-umlaut and 0xF8 is the degree sign.
+
+  g++ -O2 extras/strtab/strtab.cpp -o strtab
+  ./strtab menu_en menu_en.txt > menu_en.h
+
+In the sketch, create the menus and options without a name and give
+each its id.  Setting another table later switches every name:
+
+  #include "menu_en.h"
+  #include "menu_de.h"
+  menu.setStringTable(&menu_en);
+  menu.createMenu(0, 3, NULL, MENU_TYPE_STR);
+  menu.setMenuName(0, STR_MAIN);
+  ...
+  menu.setStringTable(&menu_de);
+
+The flash used by the plain and compressed strings is printed to stderr.
+*********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#define MAX_WORDS	127	// Token bytes are 0x80 to 0xFE
+#define ESCAPE		0xFF	// Next byte is a character from 0x80 up
+
+typedef struct
+{
+	std::string id;
+	std::string text;
+}s_entry;
+
+typedef struct
+{
+	std::string word;
+	long saving;
+}s_candidate;
+
+// Split text into words and the runs of spaces between them, so
+// "SET TIME" is "SET", " " and "TIME".  Only words go in the dictionary,
+// so "TIME" matches wherever it is in a name.
+static std::vector<std::string> splitWords(const std::string &text)
+{
+	std::vector<std::string> words;
+	size_t start = 0;
+
+	while (start < text.size())
+	{
+		bool space = (text[start] == ' ');
+		size_t end = start + 1;
+		while (end < text.size() && (text[end] == ' ') == space)
+		{
+			end++;
+		}
+		words.push_back(text.substr(start, end - start));
+		start = end;
+	}
+	return words;
+}
+
+// Bytes a word takes written out, with 8 bit characters escaped
+static long literalBytes(const std::string &word)
+{
+	long len = 0;
+	for (size_t index = 0; index < word.size(); index++)
+	{
+		len += ((uint8_t)word[index] >= 0x80) ? 2 : 1;
+	}
+	return len;
+}
+
+static bool betterCandidate(const s_candidate &a, const s_candidate &b)
+{
+	if (a.saving != b.saving)
+	{
+		return a.saving > b.saving;
+	}
+	return a.word < b.word;
+}
+
+// A single space between two dictionary words is left out, the decoder
+// puts it back
+static std::vector<uint8_t> encode(const std::string &text, const std::vector<std::string> &dict)
+{
+	std::vector<uint8_t> data;
+	std::vector<std::string> words = splitWords(text);
+	std::vector<int> tokens;
+
+	for (size_t word = 0; word < words.size(); word++)
+	{
+		std::vector<std::string>::const_iterator found = std::find(dict.begin(), dict.end(), words[word]);
+		tokens.push_back((found != dict.end()) ? (int)(found - dict.begin()) : -1);
+	}
+
+	for (size_t word = 0; word < words.size(); word++)
+	{
+		if (tokens[word] >= 0)
+		{
+			data.push_back(0x80 | tokens[word]);
+		}
+		else if (words[word] == " " && word > 0 && word + 1 < words.size() &&
+			tokens[word - 1] >= 0 && tokens[word + 1] >= 0)
+		{
+			continue;
+		}
+		else
+		{
+			for (size_t index = 0; index < words[word].size(); index++)
+			{
+				uint8_t c = words[word][index];
+				if (c >= 0x80)
+				{
+					data.push_back(ESCAPE);
+				}
+				data.push_back(c);
+			}
+		}
+	}
+	data.push_back(0);
+	return data;
+}
+
+// Flash used by the table with this dictionary
+static size_t tableBytes(const std::vector<s_entry> &entries, const std::vector<std::string> &dict)
+{
+	size_t bytes = 0;
+	for (size_t index = 0; index < dict.size(); index++)
+	{
+		bytes += dict[index].size() + 1 + 2;
+	}
+	for (size_t index = 0; index < entries.size(); index++)
+	{
+		bytes += encode(entries[index].text, dict).size() + 2;
+	}
+	return bytes;
+}
+
+// Pick the words that save the most flash.  A word used n times saves
+// about n * (written length - 1) bytes, more where it sits next to another
+// word, and costs length + 1 for the dictionary entry plus 2 for its
+// index.  Words are tried best estimate first and kept while the table
+// actually shrinks, until no word left makes it smaller.
+static std::vector<std::string> buildDictionary(const std::vector<s_entry> &entries)
+{
+	std::map<std::string, long> counts;
+	for (size_t index = 0; index < entries.size(); index++)
+	{
+		std::vector<std::string> words = splitWords(entries[index].text);
+		for (size_t word = 0; word < words.size(); word++)
+		{
+			if (words[word][0] != ' ')
+			{
+				counts[words[word]]++;
+			}
+		}
+	}
+
+	std::vector<s_candidate> candidates;
+	for (std::map<std::string, long>::iterator it = counts.begin(); it != counts.end(); ++it)
+	{
+		long len = it->first.size();
+		s_candidate candidate = { it->first, (it->second * (literalBytes(it->first) - 1)) - (len + 3) };
+		if (it->second > 1)
+		{
+			candidates.push_back(candidate);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), betterCandidate);
+
+	std::vector<std::string> dict;
+	size_t best = tableBytes(entries, dict);
+	bool added = true;
+	while (added)
+	{
+		added = false;
+		for (size_t index = 0; index < candidates.size() && dict.size() < MAX_WORDS; index++)
+		{
+			if (std::find(dict.begin(), dict.end(), candidates[index].word) != dict.end())
+			{
+				continue;
+			}
+			dict.push_back(candidates[index].word);
+			size_t bytes = tableBytes(entries, dict);
+			if (bytes < best)
+			{
+				best = bytes;
+				added = true;
+			}
+			else
+			{
+				dict.pop_back();
+			}
+		}
+	}
+	return dict;
+}
+
+static void writeBytes(const char *type, const std::string &name, const std::vector<uint8_t> &data)
+{
+	printf("static const %s %s[] PROGMEM =\n{", type, name.c_str());
+	for (size_t index = 0; index < data.size(); index++)
+	{
+		printf("%s0x%02X,", (index % 12) ? " " : "\n\t", data[index]);
+	}
+	printf("\n};\n\n");
+}
+
+static void writeWords(const std::string &name, const std::vector<uint16_t> &data)
+{
+	printf("static const uint16_t %s[] PROGMEM =\n{", name.c_str());
+	for (size_t index = 0; index < data.size(); index++)
+	{
+		printf("%s%u,", (index % 10) ? " " : "\n\t", data[index]);
+	}
+	printf("\n};\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <table name> <strings.txt>\n", argv[0]);
+		return 1;
+	}
+	std::string table = argv[1];
+
+	std::ifstream in(argv[2]);
+	if (!in)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	std::vector<s_entry> entries;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+		{
+			line.erase(line.size() - 1);
+		}
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		size_t space = line.find(' ');
+		s_entry entry;
+		entry.id = line.substr(0, space);
+		entry.text = (space == std::string::npos) ? "" : line.substr(space + 1);
+		entries.push_back(entry);
+	}
+
+	std::vector<std::string> dict = buildDictionary(entries);
+
+	std::vector<uint8_t> dictData;
+	std::vector<uint16_t> dictIndex;
+	for (size_t index = 0; index < dict.size(); index++)
+	{
+		dictIndex.push_back(dictData.size());
+		dictData.insert(dictData.end(), dict[index].begin(), dict[index].end());
+		dictData.push_back(0);
+	}
+
+	std::vector<uint8_t> stringData;
+	std::vector<uint16_t> stringIndex;
+	size_t plainBytes = 0;
+	for (size_t index = 0; index < entries.size(); index++)
+	{
+		std::vector<uint8_t> data = encode(entries[index].text, dict);
+		stringIndex.push_back(stringData.size());
+		stringData.insert(stringData.end(), data.begin(), data.end());
+		plainBytes += entries[index].text.size() + 1;
+	}
+	if (stringData.size() > 0xFFFF || dictData.size() > 0xFFFF)
+	{
+		fprintf(stderr, "%s: table is larger than 64KB\n", argv[2]);
+		return 1;
+	}
+	if (entries.size() >= 0xFFFF)
+	{
+		fprintf(stderr, "%s: too many strings\n", argv[2]);
+		return 1;
+	}
+
+	printf("// Generated by extras/strtab from %s, do not edit.\n", argv[2]);
+	printf("#ifndef _%s_H\n#define _%s_H\n\n", table.c_str(), table.c_str());
+	for (size_t index = 0; index < entries.size(); index++)
+	{
+		printf("#ifndef STR_%s\n #define STR_%s\t%u\n#endif\n",
+			entries[index].id.c_str(), entries[index].id.c_str(), (unsigned)index);
+	}
+	printf("\n");
+	writeBytes("uint8_t", table + "_dict", dictData);
+	writeWords(table + "_dict_index", dictIndex);
+	writeBytes("uint8_t", table + "_strings", stringData);
+	writeWords(table + "_string_index", stringIndex);
+	printf("static const s_strtab %s =\n{\n\t%s_dict,\n\t%s_dict_index,\n\t%s_strings,\n\t%s_string_index,\n\t%u,\n\t%u\n};\n\n",
+		table.c_str(), table.c_str(), table.c_str(), table.c_str(), table.c_str(),
+		(unsigned)dict.size(), (unsigned)entries.size());
+	printf("#endif\n");
+
+	size_t packedBytes = dictData.size() + (dictIndex.size() * 2) + stringData.size() + (stringIndex.size() * 2);
+	fprintf(stderr, "%s: %u strings, %u dictionary words\n", table.c_str(),
+		(unsigned)entries.size(), (unsigned)dict.size());
+	fprintf(stderr, "  plain PROGMEM strings  %6u bytes\n", (unsigned)plainBytes);
+	fprintf(stderr, "  compressed table       %6u bytes (%d%%)\n", (unsigned)packedBytes,
+		plainBytes ? (int)((packedBytes * 100) / plainBytes) : 0);
+	return 0;
+}